@@ -0,0 +1,270 @@
+#include "bigint.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct bench_options
+{
+	std::string format = "json";
+	std::string output;
+	std::vector<std::string> ops;
+	size_t min_bits = 32;
+	size_t max_bits = 1 << 20;
+	double min_time = 0.2;  // Seconds spent measuring every op/size pair
+	double budget = 2.0;    // Larger sizes are skipped once a single run takes longer
+};
+
+struct bench_result
+{
+	std::string op;
+	size_t bits;
+	size_t iterations;
+	double ns_per_op;
+};
+
+struct bench_operands
+{
+	bigint a;      // bits
+	bigint b;      // bits
+	bigint wide;   // 2 * bits, dividend for div
+	std::string dec;
+	int shift;
+};
+
+static volatile size_t sink;
+
+static bigint random_bigint(std::mt19937 &g, size_t bits)
+{
+	size_t nwords = (bits + 31) / 32;
+	std::string ba(nwords * 4 + 1, 0);
+
+	for (size_t i = 0; i < nwords * 4; ++i)
+		ba[i] = g();
+
+	// Force exact bit length
+	size_t top = (bits - 1) % 32;
+	uint32_t last;
+	memcpy(&last, &ba[(nwords - 1) * 4], 4);
+	last &= (top == 31) ? UINT32_MAX : ((1U << (top + 1)) - 1);
+	last |= 1U << top;
+	memcpy(&ba[(nwords - 1) * 4], &last, 4);
+
+	return bigint::from_byte_array(ba);
+}
+
+static bool measure(const std::function<size_t()> &fn, const bench_options &opts, bench_result &res)
+{
+	typedef std::chrono::steady_clock clock;
+
+	auto start = clock::now();
+	sink += fn();
+	double first = std::chrono::duration<double>(clock::now() - start).count();
+
+	size_t iterations = 1;
+	double elapsed = first;
+
+	if (first < opts.min_time)
+	{
+		start = clock::now();
+		iterations = 0;
+
+		do
+		{
+			sink += fn();
+			iterations++;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		} while (elapsed < opts.min_time);
+	}
+
+	res.iterations = iterations;
+	res.ns_per_op = elapsed * 1e9 / iterations;
+
+	return first < opts.budget;
+}
+
+static std::vector<std::pair<std::string, std::function<size_t(const bench_operands &)>>> bench_ops()
+{
+	typedef const bench_operands &ops;
+
+	return {
+		{"add", [](ops o) { return (o.a + o.b).size(); }},
+		{"sub", [](ops o) { return (o.a - o.b).size(); }},
+		{"mul", [](ops o) { return (o.a * o.b).size(); }},
+		{"square", [](ops o) { return (o.a * o.a).size(); }},
+		{"div", [](ops o) { return o.wide.div(o.a).first.size(); }},
+		{"sqrt", [](ops o) { return o.a.sqrt().size(); }},
+		{"to_string", [](ops o) { return o.a.to_string().size(); }},
+		{"conv_string", [](ops o) { return bigint(o.dec).size(); }},
+		{"shl", [](ops o) { return (o.a << o.shift).size(); }},
+		{"shr", [](ops o) { return (o.a >> o.shift).size(); }},
+		{"and", [](ops o) { return (o.a & o.b).size(); }},
+		{"or", [](ops o) { return (o.a | o.b).size(); }},
+		{"xor", [](ops o) { return (o.a ^ o.b).size(); }},
+	};
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --format=json|csv   output format (default: json)\n"
+		"  --output=FILE       write results to FILE instead of stdout\n"
+		"  --ops=a,b,...       only run the given operations\n"
+		"  --min-bits=N        smallest operand size (default: 32)\n"
+		"  --max-bits=N        largest operand size (default: 1048576)\n"
+		"  --min-time=SEC      time spent on every measurement (default: 0.2)\n"
+		"  --budget=SEC        skip larger sizes once one run exceeds SEC (default: 2)\n",
+		argv0);
+}
+
+static bool parse_args(int argc, char **argv, bench_options &opts)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		size_t eq = arg.find('=');
+		std::string key = arg.substr(0, eq);
+		std::string val = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+		if (key == "--format" && (val == "json" || val == "csv"))
+			opts.format = val;
+		else if (key == "--output")
+			opts.output = val;
+		else if (key == "--ops")
+		{
+			std::stringstream ss(val);
+			std::string op;
+
+			while (std::getline(ss, op, ','))
+				opts.ops.push_back(op);
+		}
+		else if (key == "--min-bits")
+			opts.min_bits = std::max<size_t>(1, strtoul(val.c_str(), nullptr, 10));
+		else if (key == "--max-bits")
+			opts.max_bits = strtoul(val.c_str(), nullptr, 10);
+		else if (key == "--min-time")
+			opts.min_time = strtod(val.c_str(), nullptr);
+		else if (key == "--budget")
+			opts.budget = strtod(val.c_str(), nullptr);
+		else
+			return false;
+	}
+
+	return true;
+}
+
+static void write_results(std::ostream &out, const bench_options &opts, const std::vector<bench_result> &results)
+{
+	if (opts.format == "csv")
+	{
+		out << "op,bits,limbs,iterations,ns_per_op\n";
+
+		for (auto &r : results)
+			out << r.op << ',' << r.bits << ',' << (r.bits + 31) / 32 << ',' << r.iterations << ',' << r.ns_per_op << '\n';
+
+		return;
+	}
+
+	out << "{\n";
+	out << "  \"library\": \"libbigint\",\n";
+	out << "  \"kernels\": \"" << bigint::kernel_name() << "\",\n";
+	out << "  \"results\": [";
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		auto &r = results[i];
+
+		out << (i ? ",\n" : "\n");
+		out << "    {\"op\": \"" << r.op << "\", \"bits\": " << r.bits << ", \"limbs\": " << (r.bits + 31) / 32
+		    << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.ns_per_op << "}";
+	}
+
+	out << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+	bench_options opts;
+
+	if (!parse_args(argc, argv, opts))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	auto ops = bench_ops();
+	std::vector<bool> enabled(ops.size(), opts.ops.empty());
+
+	for (auto &name : opts.ops)
+	{
+		bool found = false;
+
+		for (size_t i = 0; i < ops.size(); ++i)
+		{
+			if (ops[i].first == name)
+				enabled[i] = found = true;
+		}
+
+		if (!found)
+		{
+			fprintf(stderr, "unknown operation: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::mt19937 g(42);
+	std::vector<bench_result> results;
+
+	for (size_t bits = opts.min_bits; bits <= opts.max_bits; bits *= 2)
+	{
+		bench_operands operands;
+		operands.a = random_bigint(g, bits);
+		operands.b = random_bigint(g, bits);
+		operands.wide = random_bigint(g, 2 * bits);
+		operands.shift = bits / 2 + 3;
+
+		bool need_dec = false;
+
+		for (size_t i = 0; i < ops.size(); ++i)
+			need_dec |= enabled[i] && ops[i].first == "conv_string";
+
+		if (need_dec)
+			operands.dec = operands.a.to_string();
+
+		for (size_t i = 0; i < ops.size(); ++i)
+		{
+			if (!enabled[i])
+				continue;
+
+			bench_result res;
+			res.op = ops[i].first;
+			res.bits = bits;
+
+			auto fn = ops[i].second;
+			enabled[i] = measure([&]() { return fn(operands); }, opts, res);
+
+			results.push_back(res);
+		}
+	}
+
+	if (opts.output.empty())
+	{
+		write_results(std::cout, opts, results);
+	}
+	else
+	{
+		std::ofstream out(opts.output);
+		write_results(out, opts, results);
+	}
+
+	return 0;
+}
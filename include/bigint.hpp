@@ -23,6 +23,9 @@
 
 #pragma once
 
+#include "bigint_stats.hpp"
+
+#include <functional>
 #include <iostream>
 #include <vector>
 
@@ -49,12 +52,45 @@ private:
 	std::string txt;
 };
 
+/* Byte and word order for import_bytes/export_bytes */
+enum class bigint_order
+{
+	little = -1,
+	native = 0,
+	big = 1
+};
+
+/* Algorithm crossover points, in words */
+struct bigint_thresholds
+{
+	size_t mul_karatsuba;  // Karatsuba multiplication from this size of the shorter operand
+	size_t sqr_karatsuba;  // Karatsuba squaring
+	size_t div_bz;         // Burnikel-Ziegler division from this size of the divisor and the quotient
+	size_t get_str_dc;     // Divide-and-conquer to_string
+	size_t set_str_dc;     // Divide-and-conquer conversion from string, by the size of the result
+};
+
+class bigint_view;
+
 class BIGINT_API bigint
 {
+	friend class bigint_view;
+
 	/* Stream Operators */
 	BIGINT_API friend std::ostream &operator<<(std::ostream &s, const bigint &bi);
 	BIGINT_API friend std::istream &operator>>(std::istream &s, bigint &bi);
 
+	/* Operators on views */
+	BIGINT_API friend bigint operator+(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator-(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator*(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator/(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator%(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator&(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator|(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator^(const bigint_view &a, const bigint_view &b);
+	BIGINT_API friend bigint operator~(const bigint_view &a);
+
 public:
 	/* Constructors */
 	bigint();
@@ -67,11 +103,26 @@ public:
 	bigint(unsigned long l);
 	bigint(unsigned long long l);
 	bigint(const bigint &l);
+	bigint(bigint &&l) noexcept;  // l is left as zero, without words
+	explicit bigint(const bigint_view &v);
 
 	/* Named constructors */
 	static bigint from_byte_array(const std::string &ba);
 	static bigint from_byte_array(const char *ba, size_t sz);
 
+	/*
+	 * Uniform random values from a UniformRandomBitGenerator, written to the words directly.
+	 * random_below rejects on the top word only, the batched versions draw from one stream.
+	 */
+	template <class URBG>
+	static bigint random_bits(size_t bits, URBG &rng);  // In [0, 2^bits)
+	template <class URBG>
+	static bigint random_below(const bigint &bound, URBG &rng);  // throw, in [0, bound)
+	template <class URBG>
+	static std::vector<bigint> random_bits(size_t bits, size_t count, URBG &rng);
+	template <class URBG>
+	static std::vector<bigint> random_below(const bigint &bound, size_t count, URBG &rng);  // throw
+
 	/* Assignment Operators */
 	bigint &operator=(const char *c);
 	bigint &operator=(const std::string &s);
@@ -82,6 +133,7 @@ public:
 	bigint &operator=(unsigned long l);
 	bigint &operator=(unsigned long long l);
 	bigint &operator=(const bigint &l);
+	bigint &operator=(bigint &&l) noexcept;  // Swaps, l gets the old value
 
 	bigint &operator+=(const bigint &rhs);
 	bigint &operator-=(const bigint &rhs);
@@ -129,15 +181,61 @@ public:
 
 	/* Other Stuff */
 	bigint abs() const;
-	bigint sqrt() const;  // throw
+	bigint sqrt() const;                                        // throw
+	bigint powmod(const bigint &exp, const bigint &mod) const;  // throw, result in [0, mod)
+	bigint gcd(const bigint &rhs) const;                        // Non-negative, 0 for gcd(0, 0)
+	bigint invmod(const bigint &mod) const;                     // throw, result in [0, mod)
+	bigint divexact(const bigint &d) const;                     // throw, d must divide *this
+	bool divisible_by(const bigint &d) const;                   // Only 0 is divisible by 0
+	bool divisible_by_2exp(size_t k) const;
+
+	/* Powers of two on the words directly, mod_2exp is in [0, 2^k), fdiv rounds towards minus infinity */
+	bigint mul_2exp(size_t k) const;
+	bigint tdiv_q_2exp(size_t k) const;  // Same as >>
+	bigint fdiv_q_2exp(size_t k) const;
+	bigint mod_2exp(size_t k) const;
+
 	size_t size() const;
+	size_t bit_length() const;  // Of the magnitude, 0 for zero
+	size_t hash() const;        // Of the words and the sign, equal values hash equally
 
 	std::pair<bigint, bigint> div(const bigint &rhs) const;
 
+	/* *this += a * b and *this -= a * b without temporary bigints */
+	bigint &addmul(const bigint &a, const bigint &b);
+	bigint &submul(const bigint &a, const bigint &b);
+
+	void swap(bigint &other) noexcept;
+
+	/* Name of the kernel set selected for the running CPU */
+	static const char *kernel_name();
+
+	/* Tuned values are compiled in, see the tune executable */
+	static bigint_thresholds get_thresholds();
+	static void set_thresholds(const bigint_thresholds &t);
+
 	/* Conversion */
 	std::string to_string(int base = 10, const std::string &prefix = "") const;
 	std::string to_byte_array() const;
 
+	/*
+	 * Unsigned magnitude as an array of word_size-byte words, like mpz_import/mpz_export.
+	 * endian is the byte order inside a word, word_order is the order of the words.
+	 * The defaults match BN_bin2bn/BN_bn2bin. The sign is ignored on export.
+	 */
+	static bigint import_bytes(const void *ptr, size_t len, bigint_order endian = bigint_order::big,
+	                           bigint_order word_order = bigint_order::big, size_t word_size = 1);  // throw
+	size_t export_size(size_t word_size = 1) const;  // 0 for zero
+	size_t export_bytes(void *ptr, size_t len, bigint_order endian = bigint_order::big,
+	                    bigint_order word_order = bigint_order::big, size_t word_size = 1) const;  // throw
+
+	/* Versioned little-endian wire format, see README */
+	size_t serialized_size() const;
+	size_t serialize(char *buf, size_t len) const;                             // throw
+	static bigint deserialize(const char *buf, size_t len, size_t *used = 0);  // throw
+	/* Points into buf without copying, words must be 4-byte aligned and the host little-endian */
+	static bigint_view view_serialized(const char *buf, size_t len, size_t *used = 0);  // throw
+
 	int to_int() const;
 	long to_long() const;
 	long long to_llong() const;
@@ -148,17 +246,297 @@ public:
 private:
 	typedef uint32_t word_t;
 
-	std::vector<word_t> words;
+#ifdef BIGINT_STATS
+	typedef std::vector<word_t, bigint_stats_allocator<word_t>> words_t;
+#else
+	typedef std::vector<word_t> words_t;
+#endif
+
+	words_t words;
 	int sign;
 
 	void clamp();
 	void conv_string(const std::string &);
+	void conv_digits(const unsigned char *, size_t, int, int);
+	void conv_chunks(const word_t *, size_t, word_t, unsigned, int, int);
 	void conv_byte_array(const std::string &);
 	void conv_byte_array(const char *, size_t);
 
 	int cmp(const bigint &, bool) const;
 
-	bigint add(const bigint &) const;
-	bigint sub(const bigint &) const;
-	bigint invert(size_t) const;
+	static bigint add(const bigint_view &, const bigint_view &, bool);
+	static bigint mul(const bigint_view &, const bigint_view &);
+	static std::pair<bigint, bigint> divmod(const bigint_view &, const bigint_view &);
+	static bigint bitwise(const bigint_view &, const bigint_view &, char);
+
+	void add_mag(const word_t *, size_t, int);
+	void mul_acc(const bigint &, const bigint &, int);
+
+	static word_t random_mask(const bigint &);  // throw
+	template <class URBG>
+	static void random_words(word_t *, size_t, URBG &);
+	template <class URBG>
+	void assign_random_below(const bigint &, word_t, URBG &);
 };
+
+inline void swap(bigint &a, bigint &b) noexcept
+{
+	a.swap(b);
+}
+
+/* Random values {{{ */
+
+template <class URBG>
+void bigint::random_words(word_t *wp, size_t n, URBG &rng)
+{
+	const unsigned long long range = URBG::max() - URBG::min();
+
+	if (URBG::min() == 0 && range == UINT64_MAX)
+	{
+		size_t i = 0;
+
+		for (; i + 1 < n; i += 2)
+		{
+			uint64_t r = rng();
+			wp[i] = r;
+			wp[i + 1] = r >> 32;
+		}
+
+		if (i < n)
+			wp[i] = rng();
+	}
+	else if (URBG::min() == 0 && range == UINT32_MAX)
+	{
+		for (size_t i = 0; i < n; ++i)
+			wp[i] = rng();
+	}
+	else
+	{
+		// The whole bits of one output, larger outputs are rejected
+		unsigned bits = 0;
+
+		while (bits < 32 && (2ULL << bits) - 1 <= range)
+			bits++;
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			uint64_t acc = 0;
+
+			for (unsigned got = 0; got < 32;)
+			{
+				unsigned long long r = rng() - URBG::min();
+
+				if (r >> bits)
+					continue;
+
+				acc |= r << got;
+				got += bits;
+			}
+
+			wp[i] = acc;
+		}
+	}
+}
+
+template <class URBG>
+void bigint::assign_random_below(const bigint &bound, word_t mask, URBG &rng)
+{
+	size_t n = bound.words.size();
+	word_t top = bound.words[n - 1];
+
+	words.resize(n);
+	sign = 0;
+
+	for (;;)
+	{
+		word_t t;
+
+		do
+		{
+			random_words(&t, 1, rng);
+			t &= mask;
+		} while (t > top);
+
+		random_words(words.data(), n - 1, rng);
+		words[n - 1] = t;
+
+		if (t < top)
+			break;
+
+		// Only a top word equal to the bound's needs the rest compared
+		size_t i = n - 1;
+
+		while (i > 0 && words[i - 1] == bound.words[i - 1])
+			i--;
+
+		if (i > 0 && words[i - 1] < bound.words[i - 1])
+			break;
+	}
+
+	clamp();
+}
+
+template <class URBG>
+bigint bigint::random_bits(size_t bits, URBG &rng)
+{
+	bigint res;
+	size_t n = (bits + 31) / 32;
+
+	if (n == 0)
+		return res;
+
+	res.words.resize(n);
+	random_words(res.words.data(), n, rng);
+
+	if (bits % 32 != 0)
+		res.words[n - 1] &= (static_cast<word_t>(1) << (bits % 32)) - 1;
+
+	res.clamp();
+
+	return res;
+}
+
+template <class URBG>
+std::vector<bigint> bigint::random_bits(size_t bits, size_t count, URBG &rng)
+{
+	std::vector<bigint> res;
+	res.reserve(count);
+
+	for (size_t i = 0; i < count; ++i)
+		res.push_back(random_bits(bits, rng));
+
+	return res;
+}
+
+inline bigint::word_t bigint::random_mask(const bigint &bound)
+{
+	if (bound.sign || bound == 0)
+		throw bigint_exception("bound must be positive!");
+
+	// Ones from the top bit of the bound down
+	word_t mask = bound.words.back();
+
+	for (unsigned shift = 1; shift < 32; shift *= 2)
+		mask |= mask >> shift;
+
+	return mask;
+}
+
+template <class URBG>
+bigint bigint::random_below(const bigint &bound, URBG &rng)
+{
+	bigint res;
+	res.assign_random_below(bound, random_mask(bound), rng);
+
+	return res;
+}
+
+template <class URBG>
+std::vector<bigint> bigint::random_below(const bigint &bound, size_t count, URBG &rng)
+{
+	word_t mask = random_mask(bound);
+	std::vector<bigint> res(count);
+
+	for (auto &r : res)
+		r.assign_random_below(bound, mask, rng);
+
+	return res;
+}
+
+/* }}} Random values */
+
+/*
+ * Non-owning read-only view of a bigint: little-endian 32-bit words and a sign.
+ * The words must outlive the view.
+ *
+ * Views can be compared, printed and used as operands of the arithmetic and
+ * bitwise operators (together with bigints too) without copying the words.
+ */
+class BIGINT_API bigint_view
+{
+	friend class bigint;
+
+	BIGINT_API friend std::ostream &operator<<(std::ostream &s, const bigint_view &v);
+
+public:
+	bigint_view();  // zero
+	bigint_view(const bigint &b);
+	bigint_view(const uint32_t *words, size_t n, int sign);  // leading zero words are skipped
+
+	const uint32_t *data() const { return ptr; }
+	size_t word_count() const { return n; }  // 0 for zero
+	bool is_negative() const { return sign != 0; }
+
+	bigint_view operator-() const;
+	bigint_view abs() const;
+
+	/* -1, 0 or 1 */
+	static int compare(const bigint_view &a, const bigint_view &b);
+	static bool equal(const bigint_view &a, const bigint_view &b);  // Sizes, signs, then memcmp
+
+	size_t hash() const;  // Same as for the bigint
+
+	std::string to_string(int base = 10, const std::string &prefix = "") const;
+
+private:
+	const uint32_t *ptr;
+	size_t n;
+	int sign;
+};
+
+BIGINT_API bigint operator+(const bigint_view &a, const bigint_view &b);
+BIGINT_API bigint operator-(const bigint_view &a, const bigint_view &b);
+BIGINT_API bigint operator*(const bigint_view &a, const bigint_view &b);
+BIGINT_API bigint operator/(const bigint_view &a, const bigint_view &b);  // throw
+BIGINT_API bigint operator%(const bigint_view &a, const bigint_view &b);  // throw
+BIGINT_API bigint operator&(const bigint_view &a, const bigint_view &b);
+BIGINT_API bigint operator|(const bigint_view &a, const bigint_view &b);
+BIGINT_API bigint operator^(const bigint_view &a, const bigint_view &b);
+BIGINT_API bigint operator~(const bigint_view &a);
+
+inline bool operator==(const bigint_view &a, const bigint_view &b)
+{
+	return bigint_view::equal(a, b);
+}
+
+inline bool operator!=(const bigint_view &a, const bigint_view &b)
+{
+	return !bigint_view::equal(a, b);
+}
+
+inline bool operator<(const bigint_view &a, const bigint_view &b)
+{
+	return bigint_view::compare(a, b) < 0;
+}
+
+inline bool operator<=(const bigint_view &a, const bigint_view &b)
+{
+	return bigint_view::compare(a, b) <= 0;
+}
+
+inline bool operator>(const bigint_view &a, const bigint_view &b)
+{
+	return bigint_view::compare(a, b) > 0;
+}
+
+inline bool operator>=(const bigint_view &a, const bigint_view &b)
+{
+	return bigint_view::compare(a, b) >= 0;
+}
+
+namespace std
+{
+
+template <>
+struct hash<bigint>
+{
+	size_t operator()(const bigint &b) const { return b.hash(); }
+};
+
+template <>
+struct hash<bigint_view>
+{
+	size_t operator()(const bigint_view &v) const { return v.hash(); }
+};
+
+}  // namespace std
@@ -0,0 +1,55 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Sum of many values with deferred carries: every word is added to or subtracted
+ * from its own signed 64-bit column, and carries are propagated only every
+ * 2^31 operations and when the value is read. Adding never allocates once
+ * the columns are as wide as the widest value.
+ */
+class BIGINT_API bigint_accumulator
+{
+public:
+	bigint_accumulator();
+
+	bigint_accumulator &operator+=(const bigint_view &v);
+	bigint_accumulator &operator-=(const bigint_view &v);
+
+	bigint value() const;
+	void clear();
+
+private:
+	void add(const bigint_view &v, bool negate);
+	static int64_t normalize(std::vector<int64_t> &cols);
+
+	std::vector<int64_t> cols;
+	uint32_t pending;  // Operations since the last normalization
+};
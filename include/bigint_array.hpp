@@ -0,0 +1,99 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Columnar file of bigints for bulk loading:
+ *
+ *   header (48 bytes)
+ *     char[8] magic "BIGINTA", u32 version, u32 reserved,
+ *     u64 count, u64 total number of words,
+ *     u64 offset of the signs, u64 offset of the word offsets
+ *   words of all values back to back, u32 each
+ *   signs, one byte per value, zero padded to a multiple of 8 bytes from the start
+ *   count + 1 u64 word offsets into the words
+ *
+ * Every field is little-endian. The writer streams the words and writes
+ * the signs and offsets on close; the reader maps the file and hands out
+ * views straight into it.
+ */
+
+class BIGINT_API bigint_array_writer
+{
+public:
+	explicit bigint_array_writer(const std::string &path);  // throw
+	~bigint_array_writer();
+
+	bigint_array_writer(const bigint_array_writer &) = delete;
+	bigint_array_writer &operator=(const bigint_array_writer &) = delete;
+
+	void write(const bigint_view &v);  // throw
+	void close();                      // throw
+
+	size_t size() const { return signs.size(); }
+
+private:
+	FILE *file;
+	std::vector<uint64_t> offsets;
+	std::vector<unsigned char> signs;
+};
+
+class BIGINT_API bigint_array_reader
+{
+public:
+	explicit bigint_array_reader(const std::string &path);  // throw
+	~bigint_array_reader();
+
+	bigint_array_reader(const bigint_array_reader &) = delete;
+	bigint_array_reader &operator=(const bigint_array_reader &) = delete;
+
+	size_t size() const { return count; }
+
+	bigint_view operator[](size_t i) const
+	{
+		return bigint_view(words + offsets[i], offsets[i + 1] - offsets[i], signs[i]);
+	}
+
+	bigint_view at(size_t i) const;  // throw
+
+private:
+	void unmap();
+
+	void *map;
+	size_t map_size;
+
+	const uint32_t *words;
+	const uint64_t *offsets;
+	const unsigned char *signs;
+	size_t count;
+	uint64_t total_words;
+};
@@ -0,0 +1,71 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Fixed number of non-negative values with the same number of words, stored
+ * in structure-of-arrays layout: word j of value i is at data()[j * size() + i].
+ *
+ * The operations work on all values at once and are vectorized across values
+ * with AVX2/AVX-512 when available. Operands must have the same size().
+ */
+class BIGINT_API bigint_batch
+{
+public:
+	bigint_batch();
+	bigint_batch(size_t lanes, size_t limbs);  // zeros
+
+	size_t size() const { return lanes; }
+	size_t limbs() const { return nlimbs; }
+
+	uint32_t *data() { return words.data(); }
+	const uint32_t *data() const { return words.data(); }
+
+	void set(size_t i, const bigint_view &v);  // throw
+	bigint get(size_t i) const;
+
+	/* r = a + b and r = a - b mod 2^(32 * limbs), r may be a or b */
+	static void add(bigint_batch &r, const bigint_batch &a, const bigint_batch &b);  // throw
+	static void sub(bigint_batch &r, const bigint_batch &a, const bigint_batch &b);  // throw
+
+	/* r = a * b, r gets a.limbs() + b.limbs() limbs */
+	static void mul(bigint_batch &r, const bigint_batch &a, const bigint_batch &b);  // throw
+
+	/* r = a mod m with a common modulus m > 0, r gets the limbs of m */
+	static void mod(bigint_batch &r, const bigint_batch &a, const bigint &m);  // throw
+
+	/* -1, 0 or 1 for every value */
+	static std::vector<signed char> cmp(const bigint_batch &a, const bigint_batch &b);  // throw
+
+private:
+	std::vector<uint32_t> words;
+	size_t lanes;
+	size_t nlimbs;
+};
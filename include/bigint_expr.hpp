@@ -0,0 +1,256 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+
+#include <type_traits>
+
+/*
+ * Optional expression templates over bigint.
+ *
+ * lazy(x) starts an expression; +, - and * on it only build a tree, which is
+ * evaluated in one pass when converted to bigint or passed to assign():
+ *
+ *   using bigint_expr::lazy;
+ *
+ *   bigint r = lazy(a) * b + lazy(c) * d - e;
+ *   assign(r, lazy(r) + lazy(a) * b);  // reuses the storage of r
+ *   r -= lazy(a) * b;                  // submul
+ *
+ * Sums are accumulated in place into the destination and products under a sum
+ * become addmul/submul, so every term costs at most one temporary.
+ * Expressions hold references to their operands, which must outlive them.
+ */
+namespace bigint_expr
+{
+
+struct leaf
+{
+	const bigint &v;
+
+	explicit leaf(const bigint &v)
+		: v(v)
+	{}
+
+	const bigint &value() const { return v; }
+
+	bool aliases(const bigint *p) const { return &v == p; }
+	bool in_place(const bigint *) const { return true; }
+
+	void eval(bigint &dst) const
+	{
+		if (&v != &dst)
+			dst = v;
+	}
+
+	void add_to(bigint &dst, bool neg) const
+	{
+		if (neg)
+			dst -= v;
+		else
+			dst += v;
+	}
+
+	operator bigint() const { return v; }
+};
+
+template <class E>
+struct node
+{
+	bigint value() const
+	{
+		bigint result;
+		static_cast<const E &>(*this).eval(result);
+		return result;
+	}
+
+	operator bigint() const { return value(); }
+};
+
+template <class L, class R, bool Neg>
+struct sum : node<sum<L, R, Neg>>
+{
+	L l;
+	R r;
+
+	sum(const L &l, const R &r)
+		: l(l)
+		, r(r)
+	{}
+
+	bool aliases(const bigint *p) const { return l.aliases(p) || r.aliases(p); }
+	bool in_place(const bigint *p) const { return l.in_place(p) && !r.aliases(p); }
+
+	void eval(bigint &dst) const
+	{
+		l.eval(dst);
+		r.add_to(dst, Neg);
+	}
+
+	void add_to(bigint &dst, bool neg) const
+	{
+		l.add_to(dst, neg);
+		r.add_to(dst, neg != Neg);
+	}
+};
+
+template <class L, class R>
+struct product : node<product<L, R>>
+{
+	L l;
+	R r;
+
+	product(const L &l, const R &r)
+		: l(l)
+		, r(r)
+	{}
+
+	bool aliases(const bigint *p) const { return l.aliases(p) || r.aliases(p); }
+	bool in_place(const bigint *) const { return true; }
+
+	void eval(bigint &dst) const { dst = l.value() * r.value(); }
+
+	void add_to(bigint &dst, bool neg) const
+	{
+		if (neg)
+			dst.submul(l.value(), r.value());
+		else
+			dst.addmul(l.value(), r.value());
+	}
+};
+
+template <class T>
+struct is_expr : std::false_type
+{};
+
+template <>
+struct is_expr<leaf> : std::true_type
+{};
+
+template <class L, class R, bool Neg>
+struct is_expr<sum<L, R, Neg>> : std::true_type
+{};
+
+template <class L, class R>
+struct is_expr<product<L, R>> : std::true_type
+{};
+
+/* Plain bigint operands become leaves */
+template <class T>
+struct operand
+{
+	typedef T type;
+	static const T &wrap(const T &t) { return t; }
+};
+
+template <>
+struct operand<bigint>
+{
+	typedef leaf type;
+	static leaf wrap(const bigint &t) { return leaf(t); }
+};
+
+template <class L, class R>
+struct enable_op
+	: std::enable_if<(is_expr<L>::value && (is_expr<R>::value || std::is_same<R, bigint>::value)) ||
+	                     (std::is_same<L, bigint>::value && is_expr<R>::value),
+	                 int>
+{};
+
+template <class L, class R, bool Neg>
+struct sum_of
+{
+	typedef sum<typename operand<L>::type, typename operand<R>::type, Neg> type;
+};
+
+template <class L, class R>
+struct product_of
+{
+	typedef product<typename operand<L>::type, typename operand<R>::type> type;
+};
+
+inline leaf lazy(const bigint &v)
+{
+	return leaf(v);
+}
+
+template <class L, class R, typename enable_op<L, R>::type = 0>
+typename sum_of<L, R, false>::type operator+(const L &l, const R &r)
+{
+	return typename sum_of<L, R, false>::type(operand<L>::wrap(l), operand<R>::wrap(r));
+}
+
+template <class L, class R, typename enable_op<L, R>::type = 0>
+typename sum_of<L, R, true>::type operator-(const L &l, const R &r)
+{
+	return typename sum_of<L, R, true>::type(operand<L>::wrap(l), operand<R>::wrap(r));
+}
+
+template <class L, class R, typename enable_op<L, R>::type = 0>
+typename product_of<L, R>::type operator*(const L &l, const R &r)
+{
+	return typename product_of<L, R>::type(operand<L>::wrap(l), operand<R>::wrap(r));
+}
+
+/* dst = e, in place unless e reads dst after it has been overwritten */
+template <class E, typename std::enable_if<is_expr<E>::value, int>::type = 0>
+bigint &assign(bigint &dst, const E &e)
+{
+	if (e.in_place(&dst))
+	{
+		e.eval(dst);
+	}
+	else
+	{
+		bigint tmp;
+		e.eval(tmp);
+		dst.swap(tmp);
+	}
+
+	return dst;
+}
+
+template <class E, typename std::enable_if<is_expr<E>::value, int>::type = 0>
+bigint &operator+=(bigint &dst, const E &e)
+{
+	if (e.aliases(&dst))
+		return dst += e.value();
+
+	e.add_to(dst, false);
+	return dst;
+}
+
+template <class E, typename std::enable_if<is_expr<E>::value, int>::type = 0>
+bigint &operator-=(bigint &dst, const E &e)
+{
+	if (e.aliases(&dst))
+		return dst -= e.value();
+
+	e.add_to(dst, true);
+	return dst;
+}
+
+} // namespace bigint_expr
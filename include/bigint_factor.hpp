@@ -0,0 +1,43 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+#include "bigint_parallel.hpp"
+
+#include <vector>
+
+/*
+ * Factorization of medium-size integers. Small primes are divided out first,
+ * the cofactors are then split by Pollard's rho with Brent's cycle detection,
+ * Pollard's p-1 and finally ECM on Montgomery curves. All of them work on
+ * Montgomery residues in preallocated buffers instead of bigint temporaries.
+ */
+
+/* Miller-Rabin with the first rounds primes as bases, exact below 3.3 * 10^24 from 13 rounds on */
+BIGINT_API bool is_probable_prime(const bigint &n, int rounds = 25);
+
+/* Prime factors of |n| in ascending order with multiplicity, empty for 1. Passing an executor runs ECM curves in parallel */
+BIGINT_API std::vector<bigint> factorize(const bigint &n, bigint_executor *ex = nullptr);  // throw
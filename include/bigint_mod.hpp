@@ -0,0 +1,106 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class bigint_mod_ctx;
+
+/*
+ * Residue modulo the modulus of a bigint_mod_ctx, kept in Montgomery form in
+ * words allocated once. The context must outlive its modints, operands of the
+ * binary operators must belong to the same context.
+ */
+class BIGINT_API modint
+{
+	friend class bigint_mod_ctx;
+
+public:
+	modint();  // Not bound to a context, can only be assigned to
+
+	bigint value() const;  // throw, in [0, modulus)
+	const bigint_mod_ctx *context() const;
+
+	modint &operator+=(const modint &rhs);  // throw
+	modint &operator-=(const modint &rhs);  // throw
+	modint &operator*=(const modint &rhs);  // throw
+
+	modint operator+(const modint &rhs) const;  // throw
+	modint operator-(const modint &rhs) const;  // throw
+	modint operator*(const modint &rhs) const;  // throw
+	modint operator-() const;                   // throw
+
+	bool operator==(const modint &rhs) const;  // False for different contexts
+	bool operator!=(const modint &rhs) const;
+
+	bool is_zero() const;
+	modint inverse() const;               // throw, must be coprime to the modulus
+	modint pow(const bigint &exp) const;  // throw, negative exponents invert first
+
+private:
+	const bigint_mod_ctx *ctx;
+	std::vector<uint32_t> limbs;
+
+	explicit modint(const bigint_mod_ctx *ctx);
+
+	void check(const modint &rhs) const;
+};
+
+/*
+ * Fixed odd modulus for long sequences of modular operations. Multiplication
+ * is Montgomery's CIOS, unrolled for 256, 384, 512, 2048 and 4096-bit moduli.
+ */
+class BIGINT_API bigint_mod_ctx
+{
+	friend class modint;
+
+public:
+	explicit bigint_mod_ctx(const bigint &modulus);  // throw, must be odd and greater than one
+	~bigint_mod_ctx();
+
+	bigint_mod_ctx(const bigint_mod_ctx &) = delete;
+	bigint_mod_ctx &operator=(const bigint_mod_ctx &) = delete;
+
+	const bigint &modulus() const;
+	size_t limbs() const;  // 32-bit words per residue
+
+	modint operator()(const bigint &x) const;  // x mod modulus, of any sign
+	modint zero() const;
+	modint one() const;
+
+	/* Product of bases[i]^exps[i] in one pass, Straus' method for few bases and Pippenger's for many */
+	modint multi_pow(const std::vector<modint> &bases, const std::vector<bigint> &exps) const;  // throw
+
+	/* Inverses of all values by one inversion and 3(n - 1) multiplications, Montgomery's trick */
+	std::vector<modint> batch_inverse(const std::vector<modint> &values) const;  // throw
+
+private:
+	struct impl;
+	std::unique_ptr<impl> p;
+};
@@ -0,0 +1,99 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Small work-stealing thread pool for running the same operation over many
+ * values. Items are cut into contiguous chunks of about equal total cost,
+ * every thread starts with its own share of chunks and steals from the others
+ * once it runs out.
+ */
+class BIGINT_API bigint_executor
+{
+public:
+	explicit bigint_executor(size_t threads = 0);  // 0 for one per hardware thread
+	~bigint_executor();
+
+	bigint_executor(const bigint_executor &) = delete;
+	bigint_executor &operator=(const bigint_executor &) = delete;
+
+	size_t threads() const;  // Including the calling thread
+
+	/*
+	 * Calls fn(i) for every i in [0, n), cost(i) estimates the work of item i.
+	 * Blocks until every item is done and rethrows the first exception thrown by fn.
+	 * Nested calls from inside fn run serially.
+	 */
+	void run(size_t n, const std::function<void(size_t)> &fn, const std::function<size_t(size_t)> &cost);  // throw
+
+	static bigint_executor &shared();
+
+private:
+	struct impl;
+	std::unique_ptr<impl> p;
+};
+
+/* Cost estimates, by limb count */
+inline size_t bigint_cost(const bigint &b)
+{
+	return b.size() / 4;
+}
+
+inline size_t bigint_cost(const std::string &s)
+{
+	return s.size() / 9 + 1;  // About 9 decimal digits per limb
+}
+
+/* out[i] = fn(first[i]) for random access iterators, cost(first[i]) as in bigint_executor::run */
+template <class InputIt, class OutputIt, class Fn, class Cost>
+void parallel_transform(InputIt first, InputIt last, OutputIt out, Fn fn, Cost cost,
+                        bigint_executor &ex = bigint_executor::shared())
+{
+	size_t n = std::distance(first, last);
+
+	ex.run(n, [&](size_t i) { out[i] = fn(first[i]); }, [&](size_t i) -> size_t { return cost(first[i]); });
+}
+
+template <class InputIt, class OutputIt, class Fn>
+void parallel_transform(InputIt first, InputIt last, OutputIt out, Fn fn)
+{
+	typedef typename std::iterator_traits<InputIt>::value_type value_type;
+
+	parallel_transform(first, last, out, fn, [](const value_type &v) -> size_t { return bigint_cost(v); });
+}
+
+/* Batch entry points on the shared executor */
+BIGINT_API std::vector<bigint> parallel_powmod(const std::vector<bigint> &bases, const bigint &exp,
+                                               const bigint &mod);  // throw
+BIGINT_API std::vector<std::string> parallel_to_string(const std::vector<bigint> &values, int base = 10);
+BIGINT_API std::vector<bigint> parallel_parse(const std::vector<std::string> &strings);  // throw
@@ -0,0 +1,74 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+#include "bigint_tree.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Residue number system over word-size primes below 2^31: a value is kept as
+ * its residues modulo every prime, so that additions and multiplications are
+ * independent per prime and vectorize, products being reduced with per-prime
+ * Barrett constants. Values are reconstructed into the symmetric range
+ * (-M/2, M/2], M being the product of the primes, with Garner's algorithm for
+ * few primes and otherwise up the product tree of the primes.
+ * Passing an executor splits the work over its threads.
+ */
+class BIGINT_API bigint_rns
+{
+public:
+	typedef std::vector<uint32_t> residues;
+
+	/* Enough primes for results of up to bits bits, sign excluded */
+	explicit bigint_rns(size_t bits);
+
+	size_t size() const { return p.size(); }
+	const std::vector<uint32_t> &primes() const { return p; }
+	const bigint &modulus() const { return tree.product(); }
+
+	/* Residues through the remainder tree of the primes */
+	residues to_rns(const bigint &x, bigint_executor *ex = nullptr) const;
+	bigint from_rns(const residues &r, bigint_executor *ex = nullptr) const;  // throw
+
+	/* Elementwise, the operands must come from this context */
+	residues add(const residues &a, const residues &b, bigint_executor *ex = nullptr) const;  // throw
+	residues sub(const residues &a, const residues &b, bigint_executor *ex = nullptr) const;  // throw
+	residues mul(const residues &a, const residues &b, bigint_executor *ex = nullptr) const;  // throw
+
+private:
+	void check(const residues &a) const;
+	bigint garner_combine(const residues &r) const;
+	bigint tree_combine(const residues &r, bigint_executor *ex) const;
+
+	std::vector<uint32_t> p;
+	std::vector<uint32_t> mu;      // floor(2^62 / p[i])
+	std::vector<uint32_t> garner;  // (p[0] * ... * p[i - 1])^-1 mod p[i], for few primes
+	std::vector<uint32_t> crt;     // (M / p[i])^-1 mod p[i], otherwise
+	bigint_product_tree tree;
+	bigint half;  // M / 2
+};
@@ -0,0 +1,56 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+#include "bigint_parallel.hpp"
+
+#include <functional>
+#include <string>
+
+/*
+ * Binary splitting of hypergeometric-like series
+ *
+ *   S = sum_{n1 <= n < n2} a(n) * p(n1) * ... * p(n) / (q(n1) * ... * q(n))
+ *
+ * as S = T / Q with P = p(n1) * ... * p(n2 - 1) and Q = q(n1) * ... * q(n2 - 1).
+ * Halves are joined as P = Pl * Pr, Q = Ql * Qr, T = Tl * Qr + Pl * Tr, so that
+ * every product is between operands of about the same size.
+ */
+struct bigint_pqt
+{
+	bigint P;
+	bigint Q;
+	bigint T;
+};
+
+typedef std::function<bigint(size_t)> bigint_term;
+
+/* Passing an executor evaluates the top of the recursion in parallel */
+BIGINT_API bigint_pqt bigint_binary_split(const bigint_term &p, const bigint_term &q, const bigint_term &a, size_t n1,
+                                          size_t n2, bigint_executor *ex = nullptr);
+
+/* num / den truncated to digits decimal places, e.g. "3.14159", by one division */
+BIGINT_API std::string bigint_fixed_point(const bigint &num, const bigint &den, size_t digits);  // throw
@@ -0,0 +1,77 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+#include "bigint_parallel.hpp"
+
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Stable sort in the order of operator<: by sign, then word count, then an MSD
+ * radix sort over the bytes of the words. Small buckets fall back to comparisons.
+ * Passing an executor sorts the buckets in parallel.
+ */
+
+/* perm gets the indices of keys[0..n) in sorted order */
+BIGINT_API void bigint_sort_order(const bigint_view *keys, size_t n, size_t *perm, bigint_executor *ex = nullptr);
+
+BIGINT_API void bigint_sort(std::vector<bigint> &v, bigint_executor *ex = nullptr);
+
+/*
+ * Sorts records by key(record), which must return a bigint reference or a view
+ * that stays valid while sorting. The records are moved once.
+ */
+template <class RandomIt, class KeyFn>
+void bigint_sort_by(RandomIt first, RandomIt last, KeyFn key, bigint_executor *ex = nullptr)
+{
+	typedef typename std::iterator_traits<RandomIt>::value_type value_type;
+	typedef decltype(key(*first)) key_type;
+
+	static_assert(std::is_reference<key_type>::value ||
+	                  std::is_same<typename std::decay<key_type>::type, bigint_view>::value,
+	              "key must not return a temporary bigint");
+
+	size_t n = std::distance(first, last);
+	std::vector<bigint_view> keys;
+	std::vector<size_t> perm(n);
+
+	keys.reserve(n);
+
+	for (RandomIt it = first; it != last; ++it)
+		keys.push_back(key(*it));
+
+	bigint_sort_order(keys.data(), n, perm.data(), ex);
+
+	std::vector<value_type> sorted;
+	sorted.reserve(n);
+
+	for (size_t i = 0; i < n; ++i)
+		sorted.push_back(std::move(first[perm[i]]));
+
+	std::move(sorted.begin(), sorted.end(), first);
+}
@@ -0,0 +1,140 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "bigint_config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifdef _WIN32
+	#ifdef BIGINT_EXPORTS
+		#define BIGINT_API __declspec(dllexport)
+	#else
+		#define BIGINT_API __declspec(dllimport)
+	#endif
+#else
+	#define BIGINT_API
+#endif
+
+/*
+ * Instrumentation counters.
+ * They are only collected when the library is configured with -Dstats=true,
+ * otherwise snapshot() returns zeros and nothing is recorded.
+ */
+struct BIGINT_API bigint_stats
+{
+	enum op
+	{
+		OP_ADD,
+		OP_SUB,
+		OP_MUL,
+		OP_DIV,  // div, operator/ and operator%
+		OP_SHIFT,
+		OP_BITWISE,
+		OP_CMP,
+		OP_CONV_INT,  // Construction and assignment from built-in integers
+		OP_CONV_STRING,
+		OP_TO_STRING,
+		OP_COUNT
+	};
+
+	enum tier
+	{
+		TIER_MUL_BASECASE,
+		TIER_MUL_KARATSUBA,
+		TIER_MUL_UNBALANCED,
+		TIER_SQR_BASECASE,
+		TIER_SQR_KARATSUBA,
+		TIER_DIV_1,
+		TIER_DIV_KNUTH,
+		TIER_DIV_BZ,
+		TIER_RADIX_POW2,
+		TIER_GET_STR_BASECASE,
+		TIER_GET_STR_DC,
+		TIER_SET_STR_BASECASE,
+		TIER_SET_STR_DC,
+		TIER_COUNT
+	};
+
+	/* Bucket i counts operands of [2^i, 2^(i+1)) words */
+	static const int SIZE_BUCKETS = 32;
+
+	uint64_t calls[OP_COUNT];
+	uint64_t sizes[OP_COUNT][SIZE_BUCKETS];  // By the size of the largest operand
+
+	/* Outermost calls only, nested calls are part of their time */
+	uint64_t tier_calls[TIER_COUNT];
+	uint64_t tier_ns[TIER_COUNT];
+
+	uint64_t clamp_erased;  // Words dropped by normalization
+
+	/* Heap traffic of bigint words */
+	uint64_t allocations;
+	uint64_t allocated_bytes;
+	uint64_t deallocations;
+
+	static bool enabled();
+	static bigint_stats snapshot();
+	static void reset();
+
+	static const char *op_name(int op);
+	static const char *tier_name(int tier);
+
+	/* Used by bigint_stats_allocator */
+	static void record_alloc(size_t bytes);
+	static void record_free(size_t bytes);
+};
+
+#ifdef BIGINT_STATS
+
+template <class T>
+struct bigint_stats_allocator : std::allocator<T>
+{
+	template <class U>
+	struct rebind
+	{
+		typedef bigint_stats_allocator<U> other;
+	};
+
+	bigint_stats_allocator() {}
+
+	template <class U>
+	bigint_stats_allocator(const bigint_stats_allocator<U> &) {}
+
+	T *allocate(size_t n)
+	{
+		bigint_stats::record_alloc(n * sizeof(T));
+		return std::allocator<T>::allocate(n);
+	}
+
+	void deallocate(T *p, size_t n)
+	{
+		bigint_stats::record_free(n * sizeof(T));
+		std::allocator<T>::deallocate(p, n);
+	}
+};
+
+#endif
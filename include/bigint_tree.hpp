@@ -0,0 +1,65 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+#include "bigint_parallel.hpp"
+
+#include <vector>
+
+/*
+ * Product tree of positive values: level 0 holds the values, every level above
+ * holds the products of adjacent pairs of the level below (an odd one out is
+ * carried up as is), the last level holds the product of all values.
+ * Passing an executor evaluates every level in parallel.
+ */
+class BIGINT_API bigint_product_tree
+{
+public:
+	explicit bigint_product_tree(const std::vector<bigint> &values, bigint_executor *ex = nullptr);  // throw
+
+	size_t levels() const { return tree.size(); }
+	const std::vector<bigint> &level(size_t i) const { return tree[i]; }
+	const bigint &product() const { return tree.back()[0]; }  // 1 for no values
+
+	/*
+	 * Remainder tree: x % value for every value, or x % value^2 if squared,
+	 * reducing the remainder of a node by its children on the way down.
+	 */
+	std::vector<bigint> remainders(const bigint &x, bool squared = false, bigint_executor *ex = nullptr) const;
+
+private:
+	std::vector<std::vector<bigint>> tree;
+};
+
+/* x % m for every m in moduli, the moduli must be positive */
+BIGINT_API std::vector<bigint> batch_mod(const bigint &x, const std::vector<bigint> &moduli,
+                                         bigint_executor *ex = nullptr);  // throw
+
+/*
+ * Bernstein's batch GCD: gcd(v, product of the other values) for every v,
+ * e.g. to find RSA moduli sharing a prime. The values must be positive.
+ */
+BIGINT_API std::vector<bigint> batch_gcd(const std::vector<bigint> &values, bigint_executor *ex = nullptr);  // throw
@@ -23,52 +23,46 @@
 
 #include "bigint.hpp"
 
+#include "kernels.hpp"
+#include "magnitude.hpp"
+#include "stats.hpp"
+
 #include <algorithm>
 #include <climits>
+#include <cstring>
 #include <iostream>
 
-typedef uint64_t lword_t;
-typedef int64_t slword_t;
-
-#define WORD_BITN 32
-#define WORD_MAX UINT32_MAX
-#define WORD_MASK WORD_MAX
-#define WORD_BASE (1ULL << WORD_BITN)
-#define WORD_SIZE 4
-
-#ifdef _WIN32
-	#define CLZ(x) __lzcnt(x)
-#elif __unix__
-	#define CLZ(x) __builtin_clz(x)
-#endif
+/*
+ * Wire format, all fields little-endian:
+ *   u8 version, u8 flags (bit 0 is the sign), u16 reserved,
+ *   u32 number of words n >= 1, n u32 words starting from the least significant.
+ * The header keeps the words 4-byte aligned relative to the buffer.
+ */
+#define WIRE_VERSION 1
+#define WIRE_HEADER_SIZE 8
+#define WIRE_FLAG_SIGN 0x01
 
 /* Private {{{ */
 
 void bigint::clamp()
 {
-	for (auto it = words.end() - 1; it > words.begin(); --it)
-	{
-		if (*it != 0)
-			return;
-		else
-			words.erase(it);
-	}
+	size_t n = mag_normalized_size(words.data(), words.size());
+
+	STATS_CLAMP(words.size() - n);
+	words.resize(n);
 }
 
 void bigint::conv_string(const std::string &s)
 {
-	if (s.empty())
-	{
-		words.push_back(0);
-		sign = 0;
+	words.assign(1, 0);
+	this->sign = 0;
 
+	if (s.empty())
 		return;
-	}
 
 	int base = 10;
 	int sign = 0;
 	size_t i = 0;
-	int digit = 0;
 
 	if (s[i] == '-')
 	{
@@ -94,9 +88,14 @@ void bigint::conv_string(const std::string &s)
 		i += 2;
 	}
 
+	std::vector<unsigned char> digits;
+	digits.reserve(s.size() - i);
+
 	for (; i < s.size(); ++i)
 	{
 		char c = s[i];
+		int digit;
+
 		if (c >= '0' && c <= '9')
 			digit = c - '0';
 		else if (c >= 'A' && c <= 'Z')
@@ -109,197 +108,354 @@ void bigint::conv_string(const std::string &s)
 		if (digit >= base)
 			throw bigint_exception("string is not a number!");
 
-		*this *= base;
-		*this += digit;
+		digits.push_back(digit);
 	}
 
-	this->sign = sign;
+	conv_digits(digits.data(), digits.size(), base, sign);
 }
 
-void bigint::conv_byte_array(const std::string &ba)
+void bigint::conv_digits(const unsigned char *digits, size_t len, int base, int sign)
 {
-	if (ba.empty())
-	{
-		words.push_back(0);
-		sign = 0;
+	mag_assign(words, mag_set_str(digits, len, base));
+	STATS_OP(OP_CONV_STRING, words.size());
 
-		return;
-	}
+	this->sign = (words.size() > 1 || words[0] != 0) ? sign : 0;
+}
 
-	size_t ba_size = ba.size() - 1;
-	auto ba_iter = ba.begin();
-	words.resize(ba_size / WORD_SIZE, 0);
+void bigint::conv_chunks(const word_t *chunks, size_t n, word_t tail, unsigned tail_len, int base, int sign)
+{
+	mag_assign(words, mag_set_chunks(chunks, n, tail, tail_len, base));
+	STATS_OP(OP_CONV_STRING, words.size());
 
-	for (size_t i = 0; i < words.size(); ++i, ba_iter += WORD_SIZE)
-		std::copy_n(ba_iter, WORD_SIZE, reinterpret_cast<char *>(&words[i]));
+	this->sign = (words.size() > 1 || words[0] != 0) ? sign : 0;
+}
 
-	sign = ba.back();
+void bigint::conv_byte_array(const std::string &ba)
+{
+	conv_byte_array(ba.data(), ba.size());
 }
 
 void bigint::conv_byte_array(const char *ba, size_t sz)
 {
-	if (sz == 0)
-	{
-		words.push_back(0);
-		sign = 0;
+	words.assign(1, 0);
+	sign = 0;
 
+	if (sz == 0)
 		return;
-	}
 
 	size_t ba_size = sz - 1;
-	const char *ba_data = ba;
-	words.resize(ba_size / WORD_SIZE, 0);
 
-	for (size_t i = 0; i < words.size(); ++i, ba_data += WORD_SIZE)
-		std::copy_n(ba_data, WORD_SIZE, reinterpret_cast<char *>(&words[i]));
+	if (ba_size % WORD_SIZE != 0)
+		throw bigint_exception("byte array size is not a multiple of the word size!");
 
-	sign = ba[sz - 1];
+	if (ba_size == 0)
+		return;
+
+	words.resize(ba_size / WORD_SIZE);
+	memcpy(words.data(), ba, ba_size);
+	clamp();
+
+	if (words.size() > 1 || words[0] != 0)
+		sign = (ba[ba_size] != 0);
 }
 
 int bigint::cmp(const bigint &rhs, bool abs = false) const
 {
-	if (!abs)
+	if (abs)
+		return bigint_view::compare(bigint_view(*this).abs(), bigint_view(rhs).abs());
+
+	return bigint_view::compare(*this, rhs);
+}
+
+/* a + b, or a - b if sub */
+bigint bigint::add(const bigint_view &a, const bigint_view &rhs, bool sub)
+{
+	if (sub)
+	{
+		STATS_OP(OP_SUB, std::max(a.n, rhs.n));
+	}
+	else
 	{
-		if (sign < rhs.sign)
-			return 1;
-		if (sign > rhs.sign)
-			return -1;
+		STATS_OP(OP_ADD, std::max(a.n, rhs.n));
 	}
 
-	if (words.size() > rhs.words.size())
-		return 1;
-	if (words.size() < rhs.words.size())
-		return -1;
+	bigint_view b = sub ? -rhs : rhs;
 
-	if (words.size() == 0)
-		return 0;
+	if (b.n == 0)
+		return bigint(a);
+
+	if (a.n == 0)
+		return bigint(b);
 
-	for (size_t i = words.size() - 1; i >= 0; --i)
+	int cmp_res = bigint_view::compare(bigint_view(a.ptr, a.n, 0), bigint_view(b.ptr, b.n, 0));
+
+	const bigint_view &hi = (cmp_res >= 0) ? a : b;
+	const bigint_view &lo = (cmp_res >= 0) ? b : a;
+
+	bigint result;
+
+	if (a.sign == b.sign)
 	{
-		if (words[i] > rhs.words[i])
-			return 1;
+		result.words.resize(hi.n + 1);
 
-		if (words[i] < rhs.words[i])
-			return -1;
+		word_t *rp = result.words.data();
+		word_t carry = kernels->add_n(rp, hi.ptr, lo.ptr, lo.n);
+		carry = add_1(rp + lo.n, hi.ptr + lo.n, hi.n - lo.n, carry);
 
-		if (i == 0)
-			break;
+		if (carry != 0)
+			rp[hi.n] = carry;
+		else
+			result.words.pop_back();
+	}
+	else
+	{
+		if (cmp_res == 0)
+			return result;
+
+		result.words.resize(hi.n);
+
+		word_t *rp = result.words.data();
+		word_t borrow = kernels->sub_n(rp, hi.ptr, lo.ptr, lo.n);
+		sub_1(rp + lo.n, hi.ptr + lo.n, hi.n - lo.n, borrow);
+
+		result.clamp();
 	}
 
-	return 0;
+	result.sign = hi.sign;
+	return result;
 }
 
-bigint bigint::add(const bigint &rhs) const
+bigint bigint::mul(const bigint_view &a, const bigint_view &b)
 {
-	bigint result = 0;
+	STATS_OP(OP_MUL, std::max(a.n, b.n));
 
-	const bigint &hi = *this;
-	const bigint &lo = rhs;
+	if (a.n == 0 || b.n == 0)
+		return 0;
 
-	result.words.resize(hi.words.size(), 0);
+	const bigint_view &hi = (a.n >= b.n) ? a : b;
+	const bigint_view &lo = (a.n >= b.n) ? b : a;
 
-	word_t carry = 0;
-	size_t i = 0;
+	bigint result;
+	result.words.resize(hi.n + lo.n);
 
-	for (; i < lo.words.size(); ++i)
-	{
-		word_t hi_word = hi.words[i];
-		word_t lo_word = lo.words[i];
+	mag_mul(result.words.data(), hi.ptr, hi.n, lo.ptr, lo.n);
 
-		word_t new_word = hi_word + lo_word + carry;
+	result.clamp();
+	result.sign = a.sign ^ b.sign;
 
-		if ((lo_word == WORD_MAX && carry != 0)
-		    || (hi_word > WORD_MAX - lo_word - carry))
-			carry = 1;
-		else
-			carry = 0;
+	return result;
+}
 
-		result.words[i] = new_word;
-	}
+std::pair<bigint, bigint> bigint::divmod(const bigint_view &a, const bigint_view &b)
+{
+	STATS_OP(OP_DIV, std::max(a.n, b.n));
+
+	if (b.n == 0)
+		throw bigint_exception("division by zero");
+
+	if (bigint_view::compare(bigint_view(a.ptr, a.n, 0), bigint_view(b.ptr, b.n, 0)) < 0)
+		return std::pair<bigint, bigint>(0, bigint(a));
+
+	bigint quot;
+	bigint rem;
+
+	quot.words.resize(a.n - b.n + 1);
+	rem.words.resize(b.n);
+
+	mag_divrem(quot.words.data(), rem.words.data(), a.ptr, a.n, b.ptr, b.n);
+
+	quot.clamp();
+	rem.clamp();
+
+	if (quot.words.size() > 1 || quot.words[0] != 0)
+		quot.sign = a.sign ^ b.sign;
+
+	if (rem.words.size() > 1 || rem.words[0] != 0)
+		rem.sign = a.sign;
+
+	return std::pair<bigint, bigint>(std::move(quot), std::move(rem));
+}
+
+/*
+ * Bitwise operations with two's complement semantics.
+ * Negative operands are complemented word by word on the fly (~(m - 1)),
+ * and so is a negative result (~r + 1).
+ */
+bigint bigint::bitwise(const bigint_view &a, const bigint_view &b, char op)
+{
+	STATS_OP(OP_BITWISE, std::max(a.n, b.n));
+
+	int rsign;
+
+	if (op == '&')
+		rsign = a.sign & b.sign;
+	else if (op == '|')
+		rsign = a.sign | b.sign;
+	else
+		rsign = a.sign ^ b.sign;
+
+	// One more word for the sign extension
+	size_t n = std::max(a.n, b.n) + 1;
+
+	bigint result;
+	result.words.resize(n);
+
+	word_t *rp = result.words.data();
+	word_t aborrow = 1, bborrow = 1, carry = 1;
 
-	for (; i < hi.words.size(); ++i)
+	for (size_t i = 0; i < n; ++i)
 	{
-		word_t hi_word = hi.words[i];
-		word_t new_word = hi_word + carry;
+		word_t aw = (i < a.n) ? a.ptr[i] : 0;
+		word_t bw = (i < b.n) ? b.ptr[i] : 0;
 
-		if (hi_word > WORD_MAX - carry)
-			carry = 1;
+		if (a.sign)
+		{
+			word_t t = aw - aborrow;
+			aborrow = (aw < aborrow);
+			aw = ~t;
+		}
+
+		if (b.sign)
+		{
+			word_t t = bw - bborrow;
+			bborrow = (bw < bborrow);
+			bw = ~t;
+		}
+
+		word_t r;
+
+		if (op == '&')
+			r = aw & bw;
+		else if (op == '|')
+			r = aw | bw;
 		else
-			carry = 0;
+			r = aw ^ bw;
 
-		result.words[i] = new_word;
-	}
+		if (rsign)
+		{
+			r = ~r + carry;
+			carry = (r < carry);
+		}
 
-	if (carry != 0)
-	{
-		result.words.resize(hi.words.size() + 1, 0);
-		result.words[i] = carry;
+		rp[i] = r;
 	}
 
+	result.clamp();
+
+	if (result.words.size() > 1 || result.words[0] != 0)
+		result.sign = rsign;
+
 	return result;
 }
 
-bigint bigint::sub(const bigint &rhs) const
+/* *this += bp (negated if bsign), bp must not point into words */
+void bigint::add_mag(const word_t *bp, size_t bn, int bsign)
 {
-	bigint result = 0;
+	size_t an = words.size();
 
-	const bigint &hi = *this;
-	const bigint &lo = rhs;
+	if (mag_is_zero(bp, bn))
+		return;
 
-	result.words.resize(hi.words.size(), 0);
+	if (mag_is_zero(words.data(), an))
+	{
+		words.assign(bp, bp + bn);
+		sign = bsign;
 
-	word_t carry = 0;
-	size_t i = 0;
+		return;
+	}
 
-	for (; i < lo.words.size(); ++i)
+	if (sign == bsign)
 	{
-		word_t hi_word = hi.words[i];
-		word_t lo_word = lo.words[i];
+		size_t n = std::max(an, bn);
+		words.resize(n + 1, 0);
+
+		word_t *wp = words.data();
+		word_t carry;
 
-		word_t new_word = hi_word - lo_word - carry;
+		if (an >= bn)
+		{
+			carry = kernels->add_n(wp, wp, bp, bn);
+			carry = add_1(wp + bn, wp + bn, an - bn, carry);
+		}
+		else
+		{
+			carry = kernels->add_n(wp, wp, bp, an);
+			carry = add_1(wp + an, bp + an, bn - an, carry);
+		}
 
-		if ((hi_word == lo_word && carry != 0)
-		    || (lo_word > hi_word)
-		    || (lo_word + carry > hi_word))
-			carry = 1;
+		if (carry != 0)
+			wp[n] = carry;
 		else
-			carry = 0;
+			words.pop_back();
 
-		if (new_word != 0)
-			result.words[i] = new_word;
+		return;
 	}
 
-	for (; i < hi.words.size(); ++i)
+	int cmp_res = (an != bn) ? ((an > bn) ? 1 : -1) : mag_cmp(words.data(), bp, an);
+
+	if (cmp_res == 0)
 	{
-		word_t hi_word = hi.words[i];
-		word_t new_word = hi_word - carry;
+		words.assign(1, 0);
+		sign = 0;
 
-		if (hi_word < carry)
-			carry = 1;
-		else
-			carry = 0;
+		return;
+	}
+
+	if (cmp_res > 0)
+	{
+		word_t *wp = words.data();
+		word_t borrow = kernels->sub_n(wp, wp, bp, bn);
+		sub_1(wp + bn, wp + bn, an - bn, borrow);
+	}
+	else
+	{
+		words.resize(bn);
 
-		if (new_word != 0)
-			result.words[i] = new_word;
+		word_t *wp = words.data();
+		word_t borrow = kernels->sub_n(wp, bp, wp, an);
+		sub_1(wp + an, bp + an, bn - an, borrow);
+
+		sign = bsign;
 	}
 
-	result.clamp();
-	return result;
+	clamp();
 }
 
-bigint bigint::invert(size_t size = 0) const
+/* *this += a * b (or -= if neg) */
+void bigint::mul_acc(const bigint &a, const bigint &b, int neg)
 {
-	bigint result = *this;
+	const bigint &hi = (a.words.size() >= b.words.size()) ? a : b;
+	const bigint &lo = (a.words.size() >= b.words.size()) ? b : a;
 
-	if (size != 0 && words.size() != size)
-		result.words.resize(size, 0);
+	size_t hn = hi.words.size();
+	size_t ln = lo.words.size();
 
-	for (size_t i = 0; i < result.words.size(); ++i)
-		result.words[i] = ~result.words[i];
+	if (mag_is_zero(hi.words.data(), hn) || mag_is_zero(lo.words.data(), ln))
+		return;
 
-	result -= 1;
+	int psign = a.sign ^ b.sign ^ neg;
+	bool zero = mag_is_zero(words.data(), words.size());
 
-	return result;
+	// Fused multiply-add straight into words
+	if (ln == 1 && this != &a && this != &b && (zero || sign == psign))
+	{
+		size_t n = std::max(words.size(), hn) + 1;
+		words.resize(n, 0);
+
+		word_t *wp = words.data();
+		word_t carry = kernels->addmul_1(wp, hi.words.data(), hn, lo.words[0]);
+		add_1(wp + hn, wp + hn, n - hn, carry);
+
+		sign = psign;
+		clamp();
+
+		return;
+	}
+
+	std::vector<word_t> prod(hn + ln);
+	mag_mul(prod.data(), hi.words.data(), hn, lo.words.data(), ln);
+
+	add_mag(prod.data(), mag_normalized_size(prod.data(), prod.size()), psign);
 }
 
 /* }}} Private */
@@ -325,6 +481,8 @@ bigint::bigint(const std::string &s)
 bigint::bigint(int l)
 	: sign(l < 0)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	bool add_one = false;
 
 	if (l == INT_MIN)
@@ -346,6 +504,8 @@ bigint::bigint(int l)
 bigint::bigint(long l)
 	: sign(l < 0)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	bool add_one = false;
 
 	if (l == LONG_MIN)
@@ -371,6 +531,8 @@ bigint::bigint(long l)
 bigint::bigint(long long l)
 	: sign(l < 0)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	bool add_one = false;
 
 	if (l == LLONG_MIN)
@@ -396,12 +558,16 @@ bigint::bigint(long long l)
 bigint::bigint(unsigned int l)
 	: sign(0)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	words.push_back(l);
 }
 
 bigint::bigint(unsigned long l)
 	: sign(0)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	do
 	{
 		words.push_back(l & WORD_MASK);
@@ -412,6 +578,8 @@ bigint::bigint(unsigned long l)
 bigint::bigint(unsigned long long l)
 	: sign(0)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	do
 	{
 		words.push_back(l & WORD_MASK);
@@ -424,6 +592,21 @@ bigint::bigint(const bigint &l)
 	, sign(l.sign)
 {}
 
+bigint::bigint(const bigint_view &v)
+	: words(v.data(), v.data() + v.word_count())
+	, sign(v.is_negative())
+{
+	if (words.empty())
+		words.push_back(0);
+}
+
+bigint::bigint(bigint &&l) noexcept
+	: words(std::move(l.words))
+	, sign(l.sign)
+{
+	l.sign = 0;
+}
+
 /* }}} Constructors */
 
 /* Named constructors {{{ */
@@ -462,6 +645,8 @@ bigint &bigint::operator=(const std::string &s)
 
 bigint &bigint::operator=(int l)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	sign = l < 0;
 	words.clear();
 
@@ -487,6 +672,8 @@ bigint &bigint::operator=(int l)
 
 bigint &bigint::operator=(long l)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	sign = l < 0;
 	words.clear();
 
@@ -516,6 +703,8 @@ bigint &bigint::operator=(long l)
 
 bigint &bigint::operator=(long long l)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	sign = l < 0;
 	words.clear();
 
@@ -545,6 +734,8 @@ bigint &bigint::operator=(long long l)
 
 bigint &bigint::operator=(unsigned int l)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	sign = 0;
 	words.clear();
 	words.push_back(l);
@@ -554,6 +745,8 @@ bigint &bigint::operator=(unsigned int l)
 
 bigint &bigint::operator=(unsigned long l)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	sign = 0;
 	words.clear();
 
@@ -568,6 +761,8 @@ bigint &bigint::operator=(unsigned long l)
 
 bigint &bigint::operator=(unsigned long long l)
 {
+	STATS_OP(OP_CONV_INT, 1);
+
 	sign = 0;
 	words.clear();
 
@@ -588,15 +783,31 @@ bigint &bigint::operator=(const bigint &l)
 	return *this;
 }
 
+bigint &bigint::operator=(bigint &&l) noexcept
+{
+	swap(l);
+	return *this;
+}
+
 bigint &bigint::operator+=(const bigint &rhs)
 {
-	*this = *this + rhs;
+	STATS_OP(OP_ADD, std::max(words.size(), rhs.words.size()));
+
+	if (&rhs == this)
+		return *this <<= 1;
+
+	add_mag(rhs.words.data(), rhs.words.size(), rhs.sign);
 	return *this;
 }
 
 bigint &bigint::operator-=(const bigint &rhs)
 {
-	*this = *this - rhs;
+	STATS_OP(OP_SUB, std::max(words.size(), rhs.words.size()));
+
+	if (&rhs == this)
+		return *this = 0;
+
+	add_mag(rhs.words.data(), rhs.words.size(), !rhs.sign);
 	return *this;
 }
 
@@ -655,7 +866,10 @@ bigint &bigint::operator^=(const bigint &rhs)
 bigint bigint::operator-() const
 {
 	bigint result = *this;
-	result.sign = !sign;
+
+	if (!mag_is_zero(words.data(), words.size()))
+		result.sign = !sign;
+
 	return result;
 }
 
@@ -691,115 +905,17 @@ bigint bigint::operator++(int)
 
 bigint bigint::operator+(const bigint &rhs) const
 {
-	if (*this == 0)
-		return rhs;
-
-	if (rhs == 0)
-		return *this;
-
-	bigint result;
-	int cmp_res;
-
-	cmp_res = cmp(rhs, true);
-
-	const bigint &lo = (cmp_res > 0) ? rhs : *this;
-	const bigint &hi = (cmp_res > 0) ? *this : rhs;
-
-	if (sign == rhs.sign)
-	{
-		result = hi.add(lo);
-		result.sign = sign;
-	}
-	else
-	{
-		if (cmp_res == 0)
-			return 0;
-
-		result = hi.sub(lo);
-
-		if (cmp_res > 0)
-			result.sign = sign;
-		else
-			result.sign = rhs.sign;
-	}
-
-	return result;
+	return add(*this, rhs, false);
 }
 
 bigint bigint::operator-(const bigint &rhs) const
 {
-	if (*this == 0)
-		return -rhs;
-
-	if (rhs == 0)
-		return -*this;
-
-	bigint result;
-	int cmp_res;
-
-	cmp_res = cmp(rhs, true);
-
-	const bigint &lo = (cmp_res > 0) ? rhs : *this;
-	const bigint &hi = (cmp_res > 0) ? *this : rhs;
-
-	if (sign != rhs.sign)
-	{
-		result = hi.add(lo);
-		result.sign = sign;
-	}
-	else
-	{
-		if (cmp_res == 0)
-			return 0;
-
-		result = hi.sub(lo);
-
-		if (cmp_res > 0)
-			result.sign = sign;
-		else
-			result.sign = !rhs.sign;
-	}
-
-	return result;
+	return add(*this, rhs, true);
 }
 
 bigint bigint::operator*(const bigint &rhs) const
 {
-	if (*this == 0 || rhs == 0)
-		return 0;
-
-	bigint result = 0;
-	int cmp_res;
-
-	cmp_res = cmp(rhs, true);
-	const bigint &lo = (cmp_res > 0) ? rhs : *this;
-	const bigint &hi = (cmp_res > 0) ? *this : rhs;
-
-	result.words.resize(hi.words.size() + lo.words.size(), 0);
-
-	for (size_t i = 0; i < hi.words.size(); ++i)
-	{
-		lword_t carry = 0;
-
-		for (size_t j = 0; j < lo.words.size(); ++j)
-		{
-			lword_t res_word = result.words[i + j];
-			lword_t hi_word = hi.words[i];
-			lword_t lo_word = lo.words[j];
-
-			lword_t new_word = res_word + (hi_word * lo_word) + carry;
-
-			carry = new_word >> WORD_BITN;
-			result.words[i + j] = new_word;
-		}
-
-		result.words[i + lo.words.size()] = carry;
-	}
-
-	result.clamp();
-	result.sign = (sign + rhs.sign) % 2;
-
-	return result;
+	return mul(*this, rhs);
 }
 
 bigint bigint::operator/(const bigint &rhs) const
@@ -816,309 +932,591 @@ bigint bigint::operator%(const bigint &rhs) const
 
 bigint bigint::operator>>(int rhs) const
 {
-	if (*this == 0)
-		return 0;
+	// Negated as unsigned, -INT_MIN doesn't fit an int
+	if (rhs < 0)
+		return mul_2exp(0u - static_cast<unsigned>(rhs));
 
-	if (rhs == 0)
-		return *this;
+	return tdiv_q_2exp(rhs);
+}
 
+bigint bigint::operator<<(int rhs) const
+{
 	if (rhs < 0)
-		return *this << -rhs;
+		return tdiv_q_2exp(0u - static_cast<unsigned>(rhs));
 
-	int wrshift = rhs / WORD_BITN;
-	int rshift = rhs % WORD_BITN;
-
-	if ((size_t) wrshift >= words.size())
-		return 0;
+	return mul_2exp(rhs);
+}
 
+bigint bigint::operator~() const
+{
 	bigint result = *this;
+	result += 1;
+	result.sign = !sign;
 
-	if (wrshift != 0)
-		result.words.erase(result.words.begin(), result.words.begin() + wrshift);
-
-	if (rshift == 0)
-		return result;
-
-	int shift = WORD_BITN - rshift;
+	return result;
+}
 
-	lword_t mask = (1ULL << rshift) - 1;
-	lword_t r = 0;
+bigint bigint::operator&(const bigint &rhs) const
+{
+	return bitwise(*this, rhs, '&');
+}
 
-	for (size_t i = result.words.size() - 1; i >= 0; --i)
-	{
-		lword_t res_word = result.words[i];
-		lword_t rr = res_word & mask;
-		lword_t new_word = (res_word >> rshift) | (r << shift);
-
-		result.words[i] = new_word;
-		r = rr;
-
-		if (i == 0)
-			break;
-	}
-
-	result.clamp();
-	return result;
+bigint bigint::operator|(const bigint &rhs) const
+{
+	return bitwise(*this, rhs, '|');
 }
 
-bigint bigint::operator<<(int rhs) const
+bigint bigint::operator^(const bigint &rhs) const
 {
-	if (*this == 0)
-		return 0;
-
-	if (rhs == 0)
-		return *this;
+	return bitwise(*this, rhs, '^');
+}
 
-	if (rhs < 0)
-		return *this >> -rhs;
+/* }}} Arithmetic Operators */
 
-	int wlshift = rhs / WORD_BITN;
-	int lshift = rhs % WORD_BITN;
+/* Logical Operators {{{ */
 
-	bigint result = *this;
+bool bigint::operator!() const
+{
+	return *this == 0;
+}
 
-	if (wlshift != 0)
-	{
-		result.words.resize(result.words.size() + wlshift, 0);
-		std::move_backward(result.words.begin(), result.words.end(), result.words.end() + wlshift);
-		std::fill(result.words.begin(), result.words.begin() + wlshift, 0);
-	}
+bool bigint::operator&&(const bigint &rhs) const
+{
+	return (*this != 0 && rhs != 0);
+}
 
-	if (lshift == 0)
-		return result;
+bool bigint::operator||(const bigint &rhs) const
+{
+	return (*this != 0 || rhs != 0);
+}
 
-	int shift = WORD_BITN - lshift;
+/* }}} Logical Operators */
 
-	lword_t mask = (1ULL << lshift) - 1;
-	lword_t r = 0;
+/* Relational Operators {{{ */
 
-	for (size_t i = 0; i < result.words.size(); ++i)
-	{
-		lword_t res_word = result.words[i];
-		lword_t rr = (res_word >> shift) & mask;
-		lword_t new_word = (res_word << lshift) | r;
+bool bigint::operator==(const bigint &rhs) const
+{
+	return bigint_view::equal(*this, rhs);
+}
 
-		result.words[i] = new_word;
-		r = rr;
-	}
+bool bigint::operator!=(const bigint &rhs) const
+{
+	return !bigint_view::equal(*this, rhs);
+}
 
-	if (r != 0)
-		result.words.push_back(r);
+bool bigint::operator<(const bigint &rhs) const
+{
+	return (cmp(rhs) < 0) ? true : false;
+}
 
-	return result;
+bool bigint::operator<=(const bigint &rhs) const
+{
+	return (cmp(rhs) <= 0) ? true : false;
 }
 
-bigint bigint::operator~() const
+bool bigint::operator>(const bigint &rhs) const
 {
-	bigint result = *this;
-	result += 1;
-	result.sign = !sign;
+	return (cmp(rhs) > 0) ? true : false;
+}
 
-	return result;
+bool bigint::operator>=(const bigint &rhs) const
+{
+	return (cmp(rhs) >= 0) ? true : false;
 }
 
-bigint bigint::operator&(const bigint &rhs) const
+/* }}} Relational Operators */
+
+/* Stream operators {{{ */
+
+/*
+ * Formatted output honours basefield (dec, hex, oct), showbase ("0x", "0o"),
+ * showpos, uppercase, width, fill and adjustfield. Without a width the digits
+ * are written to the stream buffer in chunks as they are produced.
+ */
+std::ostream &operator<<(std::ostream &s, const bigint_view &v)
 {
-	int cmp_res = cmp(rhs, true);
+	std::ostream::sentry sentry(s);
+
+	if (!sentry)
+		return s;
+
+	std::ios_base::fmtflags flags = s.flags();
+	std::ios_base::fmtflags basefield = flags & std::ios_base::basefield;
+
+	int base = 10;
+
+	if (basefield == std::ios_base::hex)
+		base = 16;
+	else if (basefield == std::ios_base::oct)
+		base = 8;
+
+	bool lower = (base == 16 && !(flags & std::ios_base::uppercase));
+
+	std::string head;
+
+	if (v.sign)
+		head.push_back('-');
+	else if (flags & std::ios_base::showpos)
+		head.push_back('+');
 
-	const bigint &lo = (cmp_res > 0) ? rhs : *this;
-	const bigint &hi = (cmp_res > 0) ? *this : rhs;
+	if ((flags & std::ios_base::showbase) && base != 10)
+		head += (base == 16) ? "0x" : "0o";
 
-	bigint result = lo.sign ? lo.invert(hi.words.size()) : lo;
-	bigint nrhs = hi.sign ? hi.invert() : hi;
+	static const word_t zero = 0;
+	const word_t *ap = v.n ? v.ptr : &zero;
+	size_t n = v.n ? v.n : 1;
 
-	for (size_t i = 0; i < result.words.size(); ++i)
-		result.words[i] &= nrhs.words[i];
+	std::streambuf *sb = s.rdbuf();
+	bool ok = true;
 
-	if (hi.sign && lo.sign)
+	auto put = [&](const char *p, size_t len) {
+		ok = ok && sb->sputn(p, len) == static_cast<std::streamsize>(len);
+	};
+
+	auto to_lower = [&](char *p, size_t len) {
+		if (lower)
+			std::transform(p, p + len, p, ::tolower);
+	};
+
+	std::streamsize width = s.width(0);
+
+	if (width > 0)
 	{
-		result.sign = 1;
-		result = result.invert();
+		std::string digits = mag_get_str(ap, n, base);
+		to_lower(&digits[0], digits.size());
+
+		size_t len = head.size() + digits.size();
+		std::string fill(static_cast<size_t>(width) > len ? width - len : 0, s.fill());
+		std::ios_base::fmtflags adjust = flags & std::ios_base::adjustfield;
+
+		if (adjust == std::ios_base::left)
+			head += digits + fill;
+		else if (adjust == std::ios_base::internal)
+			head += fill + digits;
+		else
+			head = fill + head + digits;
+
+		put(head.data(), head.size());
 	}
-	else if (hi.sign || lo.sign)
-		result.sign = 0;
+	else
+	{
+		put(head.data(), head.size());
 
-	result.clamp();
-	return result;
+		mag_write_str(ap, n, base, [&](char *p, size_t len) {
+			to_lower(p, len);
+			put(p, len);
+		});
+	}
+
+	if (!ok)
+		s.setstate(std::ios_base::badbit);
+
+	return s;
 }
 
-bigint bigint::operator|(const bigint &rhs) const
+std::ostream &operator<<(std::ostream &s, const bigint &bi)
+{
+	return s << bigint_view(bi);
+}
+
+/*
+ * Formatted input reads the digits straight from the stream buffer and packs
+ * them into words as it goes, a word per 9 decimal digits.
+ * With hex or oct in basefield the number is read in that base, an optional
+ * "0x" or "0o" prefix is allowed; otherwise prefixes select the base like in
+ * conversion from string. Reading stops at the first character that isn't a digit,
+ * failbit is set if there are no digits.
+ */
+std::istream &operator>>(std::istream &s, bigint &bi)
 {
-	int cmp_res = cmp(rhs, true);
+	typedef std::char_traits<char> traits;
+
+	std::istream::sentry sentry(s);
+
+	if (!sentry)
+		return s;
+
+	std::ios_base::fmtflags basefield = s.flags() & std::ios_base::basefield;
+	bool detect = (basefield != std::ios_base::hex && basefield != std::ios_base::oct);
+
+	int base = 10;
+
+	if (basefield == std::ios_base::hex)
+		base = 16;
+	else if (basefield == std::ios_base::oct)
+		base = 8;
 
-	const bigint &lo = (cmp_res > 0) ? rhs : *this;
-	const bigint &hi = (cmp_res > 0) ? *this : rhs;
+	std::streambuf *sb = s.rdbuf();
+	bool any = false;
+	int sign = 0;
 
-	bigint result = hi.sign ? hi.invert() : hi;
-	bigint nrhs = lo.sign ? lo.invert(hi.words.size()) : lo;
+	traits::int_type c = sb->sgetc();
 
-	for (size_t i = 0; i < result.words.size(); ++i)
-		result.words[i] |= nrhs.words[i];
+	if (c == '-' || c == '+')
+	{
+		sign = (c == '-');
+		c = sb->snextc();
+	}
 
-	if (hi.sign || lo.sign)
+	if (c == '0')
 	{
-		result.sign = 1;
-		result = result.invert();
+		any = true;
+		c = sb->snextc();
+
+		if ((c == 'x' && (detect || base == 16)) || (c == 'o' && (detect || base == 8)) || (c == 'b' && detect))
+		{
+			base = (c == 'x') ? 16 : (c == 'o') ? 8 : 2;
+			c = sb->snextc();
+		}
 	}
 
-	result.clamp();
-	return result;
-}
+	// Digits are packed into words as they are read, leading zeros are dropped
+	std::vector<word_t> chunks;
+	word_t chunk = 0;
+	unsigned chunk_len = 0;
+	unsigned k = mag_chunk_digits(base);
 
-bigint bigint::operator^(const bigint &rhs) const
-{
-	int cmp_res = cmp(rhs, true);
+	while (!traits::eq_int_type(c, traits::eof()))
+	{
+		int digit;
+
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else
+			break;
 
-	const bigint &lo = (cmp_res > 0) ? rhs : *this;
-	const bigint &hi = (cmp_res > 0) ? *this : rhs;
+		if (digit >= base)
+			break;
 
-	bigint result = hi.sign ? hi.invert() : hi;
-	bigint nrhs = lo.sign ? lo.invert(hi.words.size()) : lo;
+		any = true;
+		c = sb->snextc();
 
-	for (size_t i = 0; i < result.words.size(); ++i)
-		result.words[i] ^= nrhs.words[i];
+		if (digit == 0 && chunk_len == 0 && chunks.empty())
+			continue;
 
-	if (hi.sign && lo.sign)
-		result.sign = 0;
-	else if (hi.sign || lo.sign)
-	{
-		result.sign = 1;
-		result = result.invert();
+		chunk = chunk * base + digit;
+
+		if (++chunk_len == k)
+		{
+			chunks.push_back(chunk);
+			chunk = 0;
+			chunk_len = 0;
+		}
 	}
 
-	result.clamp();
-	return result;
+	std::ios_base::iostate state = std::ios_base::goodbit;
+
+	if (traits::eq_int_type(c, traits::eof()))
+		state |= std::ios_base::eofbit;
+
+	if (!any)
+		state |= std::ios_base::failbit;
+	else
+		bi.conv_chunks(chunks.data(), chunks.size(), chunk, chunk_len, base, sign);
+
+	s.setstate(state);
+	return s;
 }
 
-/* }}} Arithmetic Operators */
+/* }}} Stream operators */
 
-/* Logical Operators {{{ */
+/* Conversion {{{ */
 
-bool bigint::operator!() const
+std::string bigint::to_string(int base, const std::string &prefix) const
 {
-	return *this == 0;
+	return bigint_view(*this).to_string(base, prefix);
 }
 
-bool bigint::operator&&(const bigint &rhs) const
+std::string bigint::to_byte_array() const
 {
-	return (*this != 0 && rhs != 0);
+	std::string result;
+	result.resize(size() + 1, 0);
+
+	if (!words.empty())
+		memcpy(&result[0], words.data(), size());
+	result.back() = sign;
+
+	return result;
 }
 
-bool bigint::operator||(const bigint &rhs) const
+static int resolve_order(bigint_order order)
 {
-	return (*this != 0 || rhs != 0);
+	if (order != bigint_order::native)
+		return static_cast<int>(order);
+
+#ifdef HOST_LITTLE_ENDIAN
+	return -1;
+#else
+	return 1;
+#endif
 }
 
-/* }}} Logical Operators */
+/* Buffer offset of byte k of the magnitude (0 is the least significant) */
+static inline size_t byte_offset(size_t k, size_t count, size_t word_size, int endian, int word_order)
+{
+	size_t w = k / word_size;
+	size_t b = k % word_size;
 
-/* Relational Operators {{{ */
+	if (word_order > 0)
+		w = count - 1 - w;
 
-bool bigint::operator==(const bigint &rhs) const
-{
-	return (cmp(rhs) == 0) ? true : false;
+	if (endian > 0)
+		b = word_size - 1 - b;
+
+	return w * word_size + b;
 }
 
-bool bigint::operator!=(const bigint &rhs) const
+static inline word_t load_be32(const unsigned char *p)
 {
-	return (cmp(rhs) != 0) ? true : false;
+	return (static_cast<word_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
 }
 
-bool bigint::operator<(const bigint &rhs) const
+static inline void store_be32(unsigned char *p, word_t w)
 {
-	return (cmp(rhs) < 0) ? true : false;
+	p[0] = w >> 24;
+	p[1] = w >> 16;
+	p[2] = w >> 8;
+	p[3] = w;
 }
 
-bool bigint::operator<=(const bigint &rhs) const
+bigint bigint::import_bytes(const void *ptr, size_t len, bigint_order endian, bigint_order word_order,
+                            size_t word_size)
 {
-	return (cmp(rhs) <= 0) ? true : false;
+	if (word_size == 0 || len % word_size != 0)
+		throw bigint_exception("byte array size is not a multiple of the word size!");
+
+	const unsigned char *p = static_cast<const unsigned char *>(ptr);
+	int e = (word_size == 1) ? resolve_order(word_order) : resolve_order(endian);
+	int o = resolve_order(word_order);
+
+	bigint result;
+
+	if (len == 0)
+		return result;
+
+	size_t n = (len + WORD_SIZE - 1) / WORD_SIZE;
+	result.words.assign(n, 0);
+	word_t *wp = result.words.data();
+
+	if (e < 0 && o < 0)
+	{
+#ifdef HOST_LITTLE_ENDIAN
+		memcpy(wp, p, len);
+#else
+		for (size_t k = 0; k < len; ++k)
+			wp[k / WORD_SIZE] |= static_cast<word_t>(p[k]) << (8 * (k % WORD_SIZE));
+#endif
+	}
+	else if (e > 0 && o > 0)
+	{
+		size_t full = len / WORD_SIZE;
+
+		for (size_t i = 0; i < full; ++i)
+			wp[i] = load_be32(p + len - WORD_SIZE * (i + 1));
+
+		for (size_t k = 0; k < len % WORD_SIZE; ++k)
+			wp[full] = (wp[full] << 8) | p[k];
+	}
+	else
+	{
+		size_t count = len / word_size;
+
+		for (size_t k = 0; k < len; ++k)
+			wp[k / WORD_SIZE] |= static_cast<word_t>(p[byte_offset(k, count, word_size, e, o)]) << (8 * (k % WORD_SIZE));
+	}
+
+	result.clamp();
+	return result;
 }
 
-bool bigint::operator>(const bigint &rhs) const
+size_t bigint::export_size(size_t word_size) const
 {
-	return (cmp(rhs) > 0) ? true : false;
+	if (word_size == 0)
+		throw bigint_exception("word size can't be zero!");
+
+	size_t bytes = (bit_length() + 7) / 8;
+	return (bytes + word_size - 1) / word_size * word_size;
 }
 
-bool bigint::operator>=(const bigint &rhs) const
+size_t bigint::export_bytes(void *ptr, size_t len, bigint_order endian, bigint_order word_order,
+                            size_t word_size) const
 {
-	return (cmp(rhs) >= 0) ? true : false;
-}
+	size_t total = export_size(word_size);
 
-/* }}} Relational Operators */
+	if (len < total)
+		throw bigint_exception("buffer is too small!");
 
-/* Stream operators {{{ */
+	unsigned char *p = static_cast<unsigned char *>(ptr);
+	int e = (word_size == 1) ? resolve_order(word_order) : resolve_order(endian);
+	int o = resolve_order(word_order);
 
-std::ostream &operator<<(std::ostream &s, const bigint &bi)
-{
-	s << bi.to_string();
-	return s;
+	size_t bytes = (bit_length() + 7) / 8;
+	const word_t *wp = words.data();
+
+	if (e < 0 && o < 0)
+	{
+#ifdef HOST_LITTLE_ENDIAN
+		if (bytes != 0)
+			memcpy(p, wp, bytes);
+#else
+		for (size_t k = 0; k < bytes; ++k)
+			p[k] = wp[k / WORD_SIZE] >> (8 * (k % WORD_SIZE));
+#endif
+		memset(p + bytes, 0, total - bytes);
+	}
+	else if (e > 0 && o > 0)
+	{
+		size_t full = bytes / WORD_SIZE;
+		size_t pad = total - bytes;
+
+		memset(p, 0, pad);
+
+		for (size_t i = 0; i < full; ++i)
+			store_be32(p + total - WORD_SIZE * (i + 1), wp[i]);
+
+		for (size_t k = 0; k < bytes % WORD_SIZE; ++k)
+			p[pad + k] = wp[full] >> (8 * (bytes % WORD_SIZE - 1 - k));
+	}
+	else
+	{
+		size_t count = total / word_size;
+
+		for (size_t k = 0; k < total; ++k)
+		{
+			unsigned char byte = (k < bytes) ? (wp[k / WORD_SIZE] >> (8 * (k % WORD_SIZE))) : 0;
+			p[byte_offset(k, count, word_size, e, o)] = byte;
+		}
+	}
+
+	return total;
 }
 
-std::istream &operator>>(std::istream &s, bigint &bi)
+size_t bigint::serialized_size() const
 {
-	std::string str;
-	s >> str;
-	bi.conv_string(str);
-	return s;
+	return WIRE_HEADER_SIZE + std::max<size_t>(words.size(), 1) * WORD_SIZE;
 }
 
-/* }}} Stream operators */
+size_t bigint::serialize(char *buf, size_t len) const
+{
+	// A moved-from bigint has no words and goes out as one zero word
+	static const word_t zero_word = 0;
+	const word_t *wp = words.empty() ? &zero_word : words.data();
 
-/* Conversion {{{ */
+	size_t n = std::max<size_t>(words.size(), 1);
+	size_t total = serialized_size();
 
-std::string bigint::to_string(int base, const std::string &prefix) const
-{
-	if (base < 2 || base > 16)
-		throw bigint_exception("base of integer can only be in the range [2, 16]");
+	if (len < total)
+		throw bigint_exception("buffer is too small!");
 
-	if (*this == 0)
-		return std::string("0");
+	if (n > UINT32_MAX)
+		throw bigint_exception("integer is too large to serialize!");
 
-	bigint tmp = *this;
-	std::string result;
+	unsigned char *p = reinterpret_cast<unsigned char *>(buf);
 
-	while (tmp != 0)
-	{
-		auto qr = tmp.div(base);
-		bigint quot = qr.first;
-		bigint rem = qr.second;
-		char c;
+	p[0] = WIRE_VERSION;
+	p[1] = sign ? WIRE_FLAG_SIGN : 0;
+	p[2] = 0;
+	p[3] = 0;
 
-		if (rem.words[0] < 10)
-			c = rem.words[0] + '0';
-		else
-			c = rem.words[0] + 'A' - 10;
+	for (int i = 0; i < 4; ++i)
+		p[4 + i] = (n >> (8 * i)) & 0xFF;
+
+	p += WIRE_HEADER_SIZE;
 
-		result.push_back(c);
-		tmp = quot;
+#ifdef HOST_LITTLE_ENDIAN
+	memcpy(p, wp, n * WORD_SIZE);
+#else
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (int j = 0; j < WORD_SIZE; ++j)
+			*p++ = (wp[i] >> (8 * j)) & 0xFF;
 	}
+#endif
+
+	return total;
+}
+
+// Checks the header, returns the number of words that follow it
+static size_t parse_wire_header(const unsigned char *p, size_t len, bool &negative)
+{
+	if (len < WIRE_HEADER_SIZE)
+		throw bigint_exception("serialized integer is truncated!");
+
+	if (p[0] != WIRE_VERSION)
+		throw bigint_exception("unsupported serialization version!");
+
+	unsigned char flags = p[1];
+
+	if ((flags & ~WIRE_FLAG_SIGN) != 0 || p[2] != 0 || p[3] != 0)
+		throw bigint_exception("serialized integer is malformed!");
+
+	size_t n = 0;
+
+	for (int i = 0; i < 4; ++i)
+		n |= static_cast<size_t>(p[4 + i]) << (8 * i);
+
+	if (n == 0)
+		throw bigint_exception("serialized integer is malformed!");
+
+	if (n > (len - WIRE_HEADER_SIZE) / WORD_SIZE)
+		throw bigint_exception("serialized integer is truncated!");
+
+	negative = (flags & WIRE_FLAG_SIGN) != 0;
+
+	return n;
+}
+
+bigint bigint::deserialize(const char *buf, size_t len, size_t *used)
+{
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(buf);
+
+	bool negative;
+	size_t n = parse_wire_header(p, len, negative);
+
+	bigint result;
+	result.words.resize(n);
+	p += WIRE_HEADER_SIZE;
+
+#ifdef HOST_LITTLE_ENDIAN
+	memcpy(result.words.data(), p, n * WORD_SIZE);
+#else
+	for (size_t i = 0; i < n; ++i, p += WORD_SIZE)
+		result.words[i] = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<word_t>(p[3]) << 24);
+#endif
 
-	for (auto iter = prefix.end() - 1; iter >= prefix.begin(); --iter)
-		result.push_back(*iter);
+	result.clamp();
 
-	if (sign == 1)
-		result.push_back('-');
+	if (result.words.size() > 1 || result.words[0] != 0)
+		result.sign = negative ? 1 : 0;
 
-	std::reverse(result.begin(), result.end());
+	if (used)
+		*used = WIRE_HEADER_SIZE + n * WORD_SIZE;
 
 	return result;
 }
 
-std::string bigint::to_byte_array() const
+bigint_view bigint::view_serialized(const char *buf, size_t len, size_t *used)
 {
-	std::string result;
-	result.resize(size() + 1, 0);
+	bool negative;
+	size_t n = parse_wire_header(reinterpret_cast<const unsigned char *>(buf), len, negative);
 
-	auto rb = result.begin();
+#ifdef HOST_LITTLE_ENDIAN
+	const char *wp = buf + WIRE_HEADER_SIZE;
 
-	for (auto it : words)
-	{
-		std::copy_n(reinterpret_cast<const char *>(&it), WORD_SIZE, rb);
-		rb += WORD_SIZE;
-	}
+	if (reinterpret_cast<uintptr_t>(wp) % alignof(word_t) != 0)
+		throw bigint_exception("serialized words are not aligned!");
 
-	result.back() = sign;
+	if (used)
+		*used = WIRE_HEADER_SIZE + n * WORD_SIZE;
 
-	return result;
+	return bigint_view(reinterpret_cast<const word_t *>(wp), n, negative);
+#else
+	throw bigint_exception("views of serialized integers need a little-endian host!");
+#endif
 }
 
 int bigint::to_int() const
@@ -1126,7 +1524,7 @@ int bigint::to_int() const
 	if (*this > INT_MAX || *this < INT_MIN)
 		throw bigint_exception("out of bounds");
 
-	int result = words[0];
+	int result = words.empty() ? 0 : words[0];
 
 	return sign ? -result : result;
 }
@@ -1138,13 +1536,10 @@ long bigint::to_long() const
 
 	long result = 0;
 
-	for (size_t i = words.size() - 1; i >= 0; --i)
+	for (size_t i = words.size(); i-- > 0;)
 	{
 		result <<= WORD_BITN;
 		result |= words[i];
-
-		if (i == 0)
-			break;
 	}
 
 	return sign ? -result : result;
@@ -1157,13 +1552,10 @@ long long bigint::to_llong() const
 
 	long long result = 0;
 
-	for (size_t i = words.size() - 1; i >= 0; --i)
+	for (size_t i = words.size(); i-- > 0;)
 	{
 		result <<= WORD_BITN;
 		result |= words[i];
-
-		if (i == 0)
-			break;
 	}
 
 	return sign ? -result : result;
@@ -1174,7 +1566,7 @@ unsigned int bigint::to_uint() const
 	if (*this > UINT_MAX || *this < 0)
 		throw bigint_exception("out of bounds");
 
-	return words[0];
+	return words.empty() ? 0 : words[0];
 }
 
 unsigned long bigint::to_ulong() const
@@ -1184,13 +1576,10 @@ unsigned long bigint::to_ulong() const
 
 	unsigned long result = 0;
 
-	for (size_t i = words.size() - 1; i >= 0; --i)
+	for (size_t i = words.size(); i-- > 0;)
 	{
 		result <<= WORD_BITN;
 		result |= words[i];
-
-		if (i == 0)
-			break;
 	}
 
 	return result;
@@ -1203,13 +1592,10 @@ unsigned long long bigint::to_ullong() const
 
 	unsigned long long result = 0;
 
-	for (size_t i = words.size() - 1; i >= 0; --i)
+	for (size_t i = words.size(); i-- > 0;)
 	{
 		result <<= WORD_BITN;
 		result |= words[i];
-
-		if (i == 0)
-			break;
 	}
 
 	return result;
@@ -1258,155 +1644,495 @@ bigint bigint::sqrt() const
 	return lo;
 }
 
-size_t bigint::size() const
+bigint bigint::powmod(const bigint &exp, const bigint &mod) const
 {
-	return words.size() * WORD_SIZE;
+	if (mod.sign || mod == 0)
+		throw bigint_exception("modulus must be positive!");
+
+	if (exp.sign)
+		throw bigint_exception("exponent must be non-negative!");
+
+	bigint base = *this % mod;
+
+	if (base.sign)
+		base += mod;
+
+	bigint result = (mod == 1) ? 0 : 1;
+
+	for (size_t i = exp.bit_length(); i-- > 0;)
+	{
+		result = result * result % mod;
+
+		if ((exp.words[i / WORD_BITN] >> (i % WORD_BITN)) & 1)
+			result = result * base % mod;
+	}
+
+	return result;
 }
 
-std::pair<bigint, bigint> bigint::div(const bigint &rhs) const
+bigint bigint::gcd(const bigint &rhs) const
+{
+	bigint a = abs();
+	bigint b = rhs.abs();
+
+	while (b != 0)
+	{
+		a %= b;
+		a.swap(b);
+	}
+
+	return a;
+}
+
+bigint bigint::invmod(const bigint &mod) const
+{
+	if (mod.sign || mod == 0)
+		throw bigint_exception("modulus must be positive!");
+
+	// Extended Euclid, s0 and s1 are the coefficients of *this
+	bigint r0 = mod, r1 = *this % mod, s0 = 0, s1 = 1;
+
+	if (r1.sign)
+		r1 += mod;
+
+	while (r1 != 0)
+	{
+		std::pair<bigint, bigint> qr = r0.div(r1);
+
+		r0.swap(r1);
+		r1 = std::move(qr.second);
+		s0.submul(qr.first, s1);
+		s0.swap(s1);
+	}
+
+	if (r0 != 1)
+		throw bigint_exception("value is not invertible!");
+
+	if (s0.sign)
+		s0 += mod;
+
+	return s0;
+}
+
+bigint bigint::divexact(const bigint &d) const
 {
-	if (rhs == 0)
+	STATS_OP(OP_DIV, std::max(words.size(), d.words.size()));
+
+	bigint_view a(*this), b(d);
+
+	if (b.n == 0)
 		throw bigint_exception("division by zero");
 
-	if (*this == 0)
-		return std::pair<bigint, bigint>(0, 0);
+	if (a.n < b.n)
+		return 0;
+
+	bigint quot;
+	quot.words.resize(a.n - b.n + 1);
 
-	if (rhs == 1)
-		return std::pair<bigint, bigint>(*this, 0);
+	mag_divexact(quot.words.data(), a.ptr, a.n, b.ptr, b.n);
+
+	quot.clamp();
+	quot.sign = (quot != 0) ? (a.sign ^ b.sign) : 0;
 
-	if (cmp(rhs, true) < 0)
-		return std::pair<bigint, bigint>(0, *this);
+	return quot;
+}
 
-	lword_t b = WORD_BASE;     // Number base
-	lword_t mask = WORD_MASK;  // Number mask b - 1
+bool bigint::divisible_by(const bigint &d) const
+{
+	STATS_OP(OP_DIV, std::max(words.size(), d.words.size()));
 
-	std::vector<word_t> tn, rn;  // Normalized form of dividend(*this) and divisor(&rhs)
-	lword_t qhat;                // Estimated quotient digit
-	lword_t rhat;                // A remainder
-	lword_t p;                   // Product of two digits
+	bigint_view a(*this), b(d);
 
-	slword_t t, k;
+	if (b.n == 0 || a.n == 0)
+		return a.n == 0;
 
-	size_t m = words.size();
-	size_t n = rhs.words.size();
+	return mag_divisible(a.ptr, a.n, b.ptr, b.n);
+}
 
-	bigint quot = 0;
-	bigint rem = 0;
+bool bigint::divisible_by_2exp(size_t k) const
+{
+	size_t w = k / WORD_BITN;
 
-	quot.sign = (sign + rhs.sign) % 2;
-	rem.sign = sign;
+	if (*this == 0)
+		return true;
 
-	quot.words.resize(m, 0);
-	rem.words.resize(m, 0);
+	if (w >= words.size())
+		return false;
 
-	if (n == 1)
+	for (size_t i = 0; i < w; ++i)
 	{
-		k = 0;
+		if (words[i] != 0)
+			return false;
+	}
 
-		for (size_t j = m - 1; j >= 0; --j)
-		{
-			quot.words[j] = (k * b + words[j]) / rhs.words[0];
-			k = (k * b + words[j]) - (quot.words[j] * rhs.words[0]);
+	return (words[w] & ((word_t(1) << (k % WORD_BITN)) - 1)) == 0;
+}
 
-			if (j == 0)
-				break;
-		}
+bigint bigint::mul_2exp(size_t k) const
+{
+	STATS_OP(OP_SHIFT, words.size());
+
+	if (*this == 0)
+		return 0;
+
+	size_t wlshift = k / WORD_BITN;
+	unsigned lshift = k % WORD_BITN;
 
-		rem.words[0] = k;
+	bigint result;
+	size_t n = words.size();
 
-		quot.clamp();
-		rem.clamp();
+	result.sign = sign;
+	result.words.resize(n + wlshift + 1, 0);
 
-		return std::pair<bigint, bigint>(quot, rem);
+	if (lshift == 0)
+	{
+		std::copy(words.begin(), words.end(), result.words.begin() + wlshift);
+		result.words.pop_back();
 	}
+	else
+	{
+		word_t r = kernels->lshift(result.words.data() + wlshift, words.data(), n, lshift);
 
-	// Normalize by shifting v left just enough so that
-	// its high-order bit is on, and shift u left the
-	// same amount.  We may have to append a high-order
-	// digit on the dividend; we do that unconditionally.
+		if (r != 0)
+			result.words[n + wlshift] = r;
+		else
+			result.words.pop_back();
+	}
 
-	int s = CLZ(rhs.words[n - 1]) + 1;
-	rn.resize(n, 0);
+	return result;
+}
 
-	for (size_t i = n - 1; i > 0; --i)
-		rn[i] = ((rhs.words[i] << s) & mask) | ((static_cast<lword_t>(rhs.words[i - 1]) >> (WORD_BITN - s)) & mask);
+bigint bigint::tdiv_q_2exp(size_t k) const
+{
+	STATS_OP(OP_SHIFT, words.size());
 
-	rn[0] = (rhs.words[0] << s) & mask;
+	size_t wrshift = k / WORD_BITN;
+	unsigned rshift = k % WORD_BITN;
 
-	tn.resize(m + 1, 0);
-	tn[m] = (words[m - 1] >> (WORD_BITN - s)) & mask;
+	if (wrshift >= words.size())
+		return 0;
 
-	for (size_t i = m - 1; i > 0; --i)
-		tn[i] = ((words[i] << s) & mask) | ((static_cast<lword_t>(words[i - 1]) >> (WORD_BITN - s)) & mask);
+	bigint result;
+	size_t n = words.size() - wrshift;
 
-	tn[0] = (words[0] << s) & mask;
+	result.words.resize(n);
 
-	for (size_t j = m - n; j >= 0; --j)  // Main loop
-	{
-		// Compute estimate qhat of q[j]
-		qhat = ((tn[j + n] * b) + tn[j + n - 1]) / (rn[n - 1]);
-		rhat = ((tn[j + n] * b) + tn[j + n - 1]) % rn[n - 1];
+	if (rshift == 0)
+		std::copy(words.begin() + wrshift, words.end(), result.words.begin());
+	else
+		kernels->rshift(result.words.data(), words.data() + wrshift, n, rshift);
 
-		while (1)
-		{
-			if (qhat >= b || (static_cast<word_t>(qhat) * static_cast<lword_t>(rn[n - 2])) > (b * rhat + tn[j + n - 2]))
-			{
-				qhat -= 1;
-				rhat += rn[n - 1];
+	result.clamp();
 
-				if (rhat < b)
-					continue;
-			}
+	if (result.words.size() > 1 || result.words[0] != 0)
+		result.sign = sign;
 
-			break;
-		}
+	return result;
+}
 
-		// Multiply and subtract
-		k = 0;
-		for (size_t i = 0; i < n; ++i)
-		{
-			p = static_cast<word_t>(qhat) * static_cast<lword_t>(rn[i]);
-			t = tn[i + j] - k - (p & mask);
-			tn[i + j] = t & mask;
-			k = (p / b) - (t / b);
-		}
+bigint bigint::fdiv_q_2exp(size_t k) const
+{
+	if (!sign)
+		return tdiv_q_2exp(k);
 
-		t = tn[j + n] - k;
-		tn[j + n] = t;
+	STATS_OP(OP_SHIFT, words.size());
 
-		quot.words[j] = qhat;  // Store quotient digit
+	// Negative values round away from zero when bits are shifted out
+	bool inexact = !divisible_by_2exp(k);
+	size_t wrshift = k / WORD_BITN;
+	unsigned rshift = k % WORD_BITN;
 
-		if (t < 0)  // If we subtracted too
-		{
-			quot.words[j] -= 1;  // ...much, add back
-			k = 0;
+	if (wrshift >= words.size())
+		return inexact ? -1 : 0;
 
-			for (size_t i = 0; i < n; ++i)
-			{
-				t = static_cast<lword_t>(tn[i + j]) + tn[i] + k;
-				tn[i + j] = t & mask;
-				k = t / b;
-			}
+	bigint result;
+	size_t n = words.size() - wrshift;
 
-			tn[j + n] = tn[j + n] + k;
-		}
+	result.sign = 1;
+	result.words.resize(n + 1, 0);
 
-		if (j == 0)
-			break;
+	if (rshift == 0)
+		std::copy(words.begin() + wrshift, words.end(), result.words.begin());
+	else
+		kernels->rshift(result.words.data(), words.data() + wrshift, n, rshift);
+
+	if (inexact)
+		add_1(result.words.data(), result.words.data(), n + 1, 1);
+
+	result.clamp();
+
+	if (result.words.size() == 1 && result.words[0] == 0)
+		result.sign = 0;
+
+	return result;
+}
+
+bigint bigint::mod_2exp(size_t k) const
+{
+	STATS_OP(OP_SHIFT, words.size());
+
+	size_t kw = (k + WORD_BITN - 1) / WORD_BITN;
+
+	if (!sign && words.size() * WORD_BITN <= k)
+		return *this;
+
+	bigint result;
+
+	if (kw == 0)
+		return result;
+
+	size_t n = std::min(words.size(), kw);
+	result.words.assign(kw, 0);
+	std::copy(words.begin(), words.begin() + n, result.words.begin());
+
+	// 2^k - (|x| mod 2^k) is the two's complement of the low k bits
+	if (sign)
+	{
+		word_t *rp = result.words.data();
+
+		for (size_t i = 0; i < kw; ++i)
+			rp[i] = ~rp[i];
+
+		add_1(rp, rp, kw, 1);
 	}
 
-	// If the caller wants the remainder, unnormalize
-	// it and pass it back.
+	if (k % WORD_BITN != 0)
+		result.words[kw - 1] &= (word_t(1) << (k % WORD_BITN)) - 1;
 
-	for (size_t i = 0; i < n; i++)
-		rem.words[i] = ((tn[i] >> s) & mask) | ((static_cast<lword_t>(tn[i + 1]) << (WORD_BITN - s)) & mask);
+	result.clamp();
 
-	rem.words[n - 1] = (tn[n - 1] >> s) & mask;
+	return result;
+}
 
-	quot.clamp();
-	rem.clamp();
+size_t bigint::size() const
+{
+	return words.size() * WORD_SIZE;
+}
+
+size_t bigint::bit_length() const
+{
+	return mag_bit_length(words.data(), words.size());
+}
+
+size_t bigint::hash() const
+{
+	return bigint_view(*this).hash();
+}
+
+std::pair<bigint, bigint> bigint::div(const bigint &rhs) const
+{
+	return divmod(*this, rhs);
+}
+
+bigint &bigint::addmul(const bigint &a, const bigint &b)
+{
+	STATS_OP(OP_MUL, std::max(a.words.size(), b.words.size()));
+
+	mul_acc(a, b, 0);
+	return *this;
+}
+
+bigint &bigint::submul(const bigint &a, const bigint &b)
+{
+	STATS_OP(OP_MUL, std::max(a.words.size(), b.words.size()));
+
+	mul_acc(a, b, 1);
+	return *this;
+}
+
+void bigint::swap(bigint &other) noexcept
+{
+	words.swap(other.words);
+	std::swap(sign, other.sign);
+}
 
-	return std::pair<bigint, bigint>(quot, rem);
+const char *bigint::kernel_name()
+{
+	return kernels->name;
+}
+
+bigint_thresholds bigint::get_thresholds()
+{
+	return thresholds;
+}
+
+void bigint::set_thresholds(const bigint_thresholds &t)
+{
+	// Karatsuba and Burnikel-Ziegler need a few words to split
+	thresholds.mul_karatsuba = std::max<size_t>(t.mul_karatsuba, 4);
+	thresholds.sqr_karatsuba = std::max<size_t>(t.sqr_karatsuba, 4);
+	thresholds.div_bz = std::max<size_t>(t.div_bz, 4);
+	thresholds.get_str_dc = std::max<size_t>(t.get_str_dc, 2);
+	thresholds.set_str_dc = std::max<size_t>(t.set_str_dc, 2);
 }
 
 /* }}} Other Stuff */
+
+/* View {{{ */
+
+bigint_view::bigint_view()
+	: ptr(nullptr)
+	, n(0)
+	, sign(0)
+{}
+
+bigint_view::bigint_view(const bigint &b)
+	: ptr(b.words.data())
+	, n(b.words.size())
+	, sign(b.sign)
+{
+	if (mag_is_zero(ptr, n))
+	{
+		n = 0;
+		sign = 0;
+	}
+}
+
+bigint_view::bigint_view(const uint32_t *words, size_t n, int sign)
+	: ptr(words)
+	, n(n)
+	, sign(0)
+{
+	while (this->n > 0 && ptr[this->n - 1] == 0)
+		this->n--;
+
+	if (this->n != 0)
+		this->sign = (sign != 0);
+}
+
+bigint_view bigint_view::operator-() const
+{
+	return bigint_view(ptr, n, !sign);
+}
+
+bigint_view bigint_view::abs() const
+{
+	return bigint_view(ptr, n, 0);
+}
+
+int bigint_view::compare(const bigint_view &a, const bigint_view &b)
+{
+	STATS_OP(OP_CMP, std::max(a.n, b.n));
+
+	if (a.sign != b.sign)
+		return a.sign ? -1 : 1;
+
+	int res;
+
+	if (a.n != b.n)
+		res = (a.n > b.n) ? 1 : -1;
+	else
+		res = mag_cmp(a.ptr, b.ptr, a.n);
+
+	return a.sign ? -res : res;
+}
+
+bool bigint_view::equal(const bigint_view &a, const bigint_view &b)
+{
+	STATS_OP(OP_CMP, std::max(a.n, b.n));
+
+	if (a.n != b.n || a.sign != b.sign)
+		return false;
+
+	return a.n == 0 || memcmp(a.ptr, b.ptr, a.n * sizeof(word_t)) == 0;
+}
+
+static inline uint64_t hash_fmix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+// Two words per multiply, finished with the MurmurHash3 mixer
+size_t bigint_view::hash() const
+{
+	const uint64_t k = 0x9E3779B97F4A7C15ULL;
+	uint64_t h = n * k ^ sign;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		uint64_t v = ptr[i] | static_cast<uint64_t>(ptr[i + 1]) << WORD_BITN;
+		h = (h ^ v) * k;
+		h ^= h >> 29;
+	}
+
+	if (i < n)
+		h = (h ^ ptr[i]) * k;
+
+	return hash_fmix(h);
+}
+
+std::string bigint_view::to_string(int base, const std::string &prefix) const
+{
+	STATS_OP(OP_TO_STRING, n);
+
+	if (base < 2 || base > 16)
+		throw bigint_exception("base of integer can only be in the range [2, 16]");
+
+	if (n == 0)
+		return std::string("0");
+
+	std::string result;
+
+	if (sign == 1)
+		result.push_back('-');
+
+	result += prefix;
+	result += mag_get_str(ptr, n, base);
+
+	return result;
+}
+
+bigint operator+(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::add(a, b, false);
+}
+
+bigint operator-(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::add(a, b, true);
+}
+
+bigint operator*(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::mul(a, b);
+}
+
+bigint operator/(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::divmod(a, b).first;
+}
+
+bigint operator%(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::divmod(a, b).second;
+}
+
+bigint operator&(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::bitwise(a, b, '&');
+}
+
+bigint operator|(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::bitwise(a, b, '|');
+}
+
+bigint operator^(const bigint_view &a, const bigint_view &b)
+{
+	return bigint::bitwise(a, b, '^');
+}
+
+bigint operator~(const bigint_view &a)
+{
+	static const uint32_t one = 1;
+	return bigint::bitwise(a, bigint_view(&one, 1, 1), '^');
+}
+
+/* }}} View */
@@ -0,0 +1,119 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_accumulator.hpp"
+
+#include "kernels.hpp"
+
+// Below 2^63 / 2^32, so that the columns can't overflow
+#define ACC_MAX_PENDING 0x7FFFFFFF
+
+bigint_accumulator::bigint_accumulator()
+	: pending(0)
+{}
+
+bigint_accumulator &bigint_accumulator::operator+=(const bigint_view &v)
+{
+	add(v, false);
+	return *this;
+}
+
+bigint_accumulator &bigint_accumulator::operator-=(const bigint_view &v)
+{
+	add(v, true);
+	return *this;
+}
+
+void bigint_accumulator::add(const bigint_view &v, bool negate)
+{
+	size_t n = v.word_count();
+	const word_t *vp = v.data();
+
+	if (n == 0)
+		return;
+
+	if (pending == ACC_MAX_PENDING)
+	{
+		int64_t carry = normalize(cols);
+
+		if (carry != 0)
+			cols.push_back(carry);
+
+		pending = 1;  // The top column is small after the normalization
+	}
+
+	if (cols.size() < n)
+		cols.resize(n, 0);
+
+	int64_t *cp = cols.data();
+
+	if (negate != v.is_negative())
+	{
+		for (size_t i = 0; i < n; ++i)
+			cp[i] -= vp[i];
+	}
+	else
+	{
+		for (size_t i = 0; i < n; ++i)
+			cp[i] += vp[i];
+	}
+
+	pending++;
+}
+
+/* Leaves every column in [0, 2^32), returns the carry out of the top one */
+int64_t bigint_accumulator::normalize(std::vector<int64_t> &cols)
+{
+	int64_t carry = 0;
+
+	for (auto &c : cols)
+	{
+		int64_t v = c + carry;
+
+		c = v & WORD_MASK;
+		carry = v >> WORD_BITN;  // Rounds towards minus infinity
+	}
+
+	return carry;
+}
+
+bigint bigint_accumulator::value() const
+{
+	std::vector<int64_t> tmp = cols;
+	int64_t carry = normalize(tmp);
+
+	std::vector<word_t> words(tmp.begin(), tmp.end());
+	bigint result(bigint_view(words.data(), words.size(), 0));
+
+	if (carry != 0)
+		result += bigint(static_cast<long long>(carry)) << static_cast<int>(WORD_BITN * words.size());
+
+	return result;
+}
+
+void bigint_accumulator::clear()
+{
+	cols.clear();
+	pending = 0;
+}
@@ -0,0 +1,325 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_array.hpp"
+
+#include "kernels.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#define ARRAY_MAGIC "BIGINTA"
+#define ARRAY_VERSION 1
+#define ARRAY_HEADER_SIZE 48
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+		p[i] = v >> (8 * i);
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+	for (int i = 0; i < 8; ++i)
+		p[i] = v >> (8 * i);
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+	uint32_t v = 0;
+
+	for (int i = 0; i < 4; ++i)
+		v |= static_cast<uint32_t>(p[i]) << (8 * i);
+
+	return v;
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+	uint64_t v = 0;
+
+	for (int i = 0; i < 8; ++i)
+		v |= static_cast<uint64_t>(p[i]) << (8 * i);
+
+	return v;
+}
+
+static uint64_t pad8(uint64_t n)
+{
+	return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+/* Writer {{{ */
+
+bigint_array_writer::bigint_array_writer(const std::string &path)
+	: file(fopen(path.c_str(), "wb"))
+{
+	if (!file)
+		throw bigint_exception("can't open " + path + " for writing!");
+
+	setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+	// Filled in by close()
+	unsigned char header[ARRAY_HEADER_SIZE] = {};
+
+	if (fwrite(header, 1, sizeof(header), file) != sizeof(header))
+	{
+		fclose(file);
+		throw bigint_exception("can't write " + path + "!");
+	}
+
+	offsets.push_back(0);
+}
+
+bigint_array_writer::~bigint_array_writer()
+{
+	try
+	{
+		close();
+	}
+	catch (bigint_exception &)
+	{}
+}
+
+void bigint_array_writer::write(const bigint_view &v)
+{
+	if (!file)
+		throw bigint_exception("writer is closed!");
+
+	size_t n = v.word_count();
+
+#ifdef HOST_LITTLE_ENDIAN
+	size_t written = fwrite(v.data(), WORD_SIZE, n, file);
+#else
+	size_t written = 0;
+
+	for (; written < n; ++written)
+	{
+		unsigned char w[WORD_SIZE];
+		put_u32(w, v.data()[written]);
+
+		if (fwrite(w, 1, WORD_SIZE, file) != WORD_SIZE)
+			break;
+	}
+#endif
+
+	if (written != n)
+		throw bigint_exception("can't write bigint array!");
+
+	offsets.push_back(offsets.back() + n);
+	signs.push_back(v.is_negative());
+}
+
+void bigint_array_writer::close()
+{
+	if (!file)
+		return;
+
+	FILE *f = file;
+	file = nullptr;
+
+	uint64_t count = signs.size();
+	uint64_t total = offsets.back();
+	uint64_t signs_offset = ARRAY_HEADER_SIZE + total * WORD_SIZE;
+	uint64_t offsets_offset = pad8(signs_offset + count);
+
+	signs.resize(offsets_offset - signs_offset, 0);
+	bool ok = fwrite(signs.data(), 1, signs.size(), f) == signs.size();
+
+#ifdef HOST_LITTLE_ENDIAN
+	ok = ok && fwrite(offsets.data(), 8, offsets.size(), f) == offsets.size();
+#else
+	for (size_t i = 0; ok && i < offsets.size(); ++i)
+	{
+		unsigned char o[8];
+		put_u64(o, offsets[i]);
+		ok = fwrite(o, 1, 8, f) == 8;
+	}
+#endif
+
+	unsigned char header[ARRAY_HEADER_SIZE] = {};
+	memcpy(header, ARRAY_MAGIC, 8);
+	put_u32(header + 8, ARRAY_VERSION);
+	put_u64(header + 16, count);
+	put_u64(header + 24, total);
+	put_u64(header + 32, signs_offset);
+	put_u64(header + 40, offsets_offset);
+
+	ok = ok && fseek(f, 0, SEEK_SET) == 0;
+	ok = ok && fwrite(header, 1, sizeof(header), f) == sizeof(header);
+	ok = (fclose(f) == 0) && ok;
+
+	signs.clear();
+	offsets.assign(1, 0);
+
+	if (!ok)
+		throw bigint_exception("can't write bigint array!");
+}
+
+/* }}} Writer */
+
+/* Reader {{{ */
+
+bigint_array_reader::bigint_array_reader(const std::string &path)
+	: map(nullptr)
+	, map_size(0)
+{
+#ifdef _WIN32
+	HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (fh == INVALID_HANDLE_VALUE)
+		throw bigint_exception("can't open " + path + "!");
+
+	LARGE_INTEGER fsize;
+	HANDLE mh = nullptr;
+
+	if (GetFileSizeEx(fh, &fsize) && fsize.QuadPart >= ARRAY_HEADER_SIZE)
+	{
+		map_size = fsize.QuadPart;
+		mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+
+	if (mh)
+	{
+		map = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mh);
+	}
+
+	CloseHandle(fh);
+
+	if (!map)
+		throw bigint_exception("can't map " + path + "!");
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		throw bigint_exception("can't open " + path + "!");
+
+	struct stat st;
+
+	if (fstat(fd, &st) == 0 && st.st_size >= ARRAY_HEADER_SIZE)
+	{
+		map_size = st.st_size;
+	#ifdef HOST_LITTLE_ENDIAN
+		map = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	#else
+		// Private writable mapping, the words are swapped in place below
+		map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	#endif
+
+		if (map == MAP_FAILED)
+			map = nullptr;
+	}
+
+	::close(fd);
+
+	if (!map)
+		throw bigint_exception("can't map " + path + "!");
+
+	madvise(map, map_size, MADV_WILLNEED);
+#endif
+
+	const unsigned char *p = static_cast<const unsigned char *>(map);
+
+	count = get_u64(p + 16);
+	total_words = get_u64(p + 24);
+
+	uint64_t signs_offset = get_u64(p + 32);
+	uint64_t offsets_offset = get_u64(p + 40);
+	uint64_t avail = map_size - ARRAY_HEADER_SIZE;
+
+	bool ok = memcmp(p, ARRAY_MAGIC, 8) == 0 && get_u32(p + 8) == ARRAY_VERSION;
+
+	ok = ok && total_words <= avail / WORD_SIZE && count <= avail / 9;
+	ok = ok && signs_offset == ARRAY_HEADER_SIZE + total_words * WORD_SIZE;
+	ok = ok && offsets_offset == pad8(signs_offset + count);
+	ok = ok && offsets_offset + (count + 1) * 8 <= map_size;
+
+	if (ok)
+	{
+		words = reinterpret_cast<const uint32_t *>(p + ARRAY_HEADER_SIZE);
+		signs = p + signs_offset;
+		offsets = reinterpret_cast<const uint64_t *>(p + offsets_offset);
+
+#ifndef HOST_LITTLE_ENDIAN
+		uint32_t *w = const_cast<uint32_t *>(words);
+		uint64_t *o = const_cast<uint64_t *>(offsets);
+
+		for (uint64_t i = 0; i < total_words; ++i)
+			w[i] = get_u32(reinterpret_cast<const unsigned char *>(w + i));
+
+		for (uint64_t i = 0; i <= count; ++i)
+			o[i] = get_u64(reinterpret_cast<const unsigned char *>(o + i));
+#endif
+
+		ok = offsets[0] == 0 && offsets[count] == total_words;
+	}
+
+	if (!ok)
+	{
+		unmap();
+		throw bigint_exception(path + " is not a valid bigint array!");
+	}
+}
+
+bigint_array_reader::~bigint_array_reader()
+{
+	unmap();
+}
+
+void bigint_array_reader::unmap()
+{
+	if (!map)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(map);
+#else
+	munmap(map, map_size);
+#endif
+
+	map = nullptr;
+}
+
+bigint_view bigint_array_reader::at(size_t i) const
+{
+	if (i >= count)
+		throw bigint_exception("index is out of range!");
+
+	if (offsets[i] > offsets[i + 1] || offsets[i + 1] > total_words)
+		throw bigint_exception("bigint array is malformed!");
+
+	return (*this)[i];
+}
+
+/* }}} Reader */
@@ -0,0 +1,223 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_batch.hpp"
+
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static void check_lanes(const bigint_batch &a, const bigint_batch &b)
+{
+	if (a.size() != b.size())
+		throw bigint_exception("batch sizes don't match!");
+}
+
+// Every lane set to v
+static bigint_batch broadcast(const bigint_view &v, size_t lanes, size_t limbs)
+{
+	bigint_batch r(lanes, limbs);
+	word_t *rp = r.data();
+
+	for (size_t j = 0; j < v.word_count(); ++j)
+		std::fill(rp + j * lanes, rp + (j + 1) * lanes, v.data()[j]);
+
+	return r;
+}
+
+bigint_batch::bigint_batch()
+	: lanes(0)
+	, nlimbs(0)
+{}
+
+bigint_batch::bigint_batch(size_t lanes, size_t limbs)
+	: words(lanes * limbs)
+	, lanes(lanes)
+	, nlimbs(limbs)
+{}
+
+void bigint_batch::set(size_t i, const bigint_view &v)
+{
+	if (i >= lanes)
+		throw bigint_exception("index is out of range!");
+
+	if (v.is_negative())
+		throw bigint_exception("batches hold non-negative values only!");
+
+	if (v.word_count() > nlimbs)
+		throw bigint_exception("value doesn't fit into the batch!");
+
+	for (size_t j = 0; j < nlimbs; ++j)
+		words[j * lanes + i] = (j < v.word_count()) ? v.data()[j] : 0;
+}
+
+bigint bigint_batch::get(size_t i) const
+{
+	std::vector<word_t> w(nlimbs);
+
+	for (size_t j = 0; j < nlimbs; ++j)
+		w[j] = words[j * lanes + i];
+
+	return bigint(bigint_view(w.data(), nlimbs, 0));
+}
+
+void bigint_batch::add(bigint_batch &r, const bigint_batch &a, const bigint_batch &b)
+{
+	check_lanes(a, b);
+
+	if (a.nlimbs != b.nlimbs)
+		throw bigint_exception("batches must have the same number of limbs!");
+
+	if (&r != &a && &r != &b)
+		r = bigint_batch(a.lanes, a.nlimbs);
+
+	kernels->batch_add(r.data(), a.data(), b.data(), a.lanes, a.nlimbs);
+}
+
+void bigint_batch::sub(bigint_batch &r, const bigint_batch &a, const bigint_batch &b)
+{
+	check_lanes(a, b);
+
+	if (a.nlimbs != b.nlimbs)
+		throw bigint_exception("batches must have the same number of limbs!");
+
+	if (&r != &a && &r != &b)
+		r = bigint_batch(a.lanes, a.nlimbs);
+
+	kernels->batch_sub(r.data(), a.data(), b.data(), a.lanes, a.nlimbs);
+}
+
+void bigint_batch::mul(bigint_batch &r, const bigint_batch &a, const bigint_batch &b)
+{
+	check_lanes(a, b);
+
+	bigint_batch res(a.lanes, a.nlimbs + b.nlimbs);
+
+	if (a.nlimbs != 0 && b.nlimbs != 0)
+		kernels->batch_mul(res.data(), a.data(), a.nlimbs, b.data(), b.nlimbs, a.lanes);
+
+	r = std::move(res);
+}
+
+/*
+ * Barrett reduction, since the modulus is shared by all lanes:
+ * with k words in m and mu = floor(b^2k / m), the quotient estimate
+ * floor(floor(a / b^(k-1)) * mu / b^(k+1)) is off by at most 2 for a < b^2k.
+ */
+void bigint_batch::mod(bigint_batch &r, const bigint_batch &a, const bigint &m)
+{
+	bigint_view mv(m);
+
+	if (mv.word_count() == 0 || mv.is_negative())
+		throw bigint_exception("modulus must be positive!");
+
+	size_t k = mv.word_count();
+	size_t n = a.nlimbs;
+	size_t lanes = a.lanes;
+
+	bigint_batch res(lanes, k);
+
+	if (n < k)
+	{
+		// Already reduced
+		memcpy(res.data(), a.data(), lanes * n * sizeof(word_t));
+	}
+	else if (n > 2 * k)
+	{
+		for (size_t i = 0; i < lanes; ++i)
+			res.set(i, a.get(i) % m);
+	}
+	else if (lanes != 0)
+	{
+		bigint mu = (bigint(1) << static_cast<int>(2 * k * WORD_BITN)) / m;
+		size_t mun = bigint_view(mu).word_count();
+
+		bigint_batch mub = broadcast(mu, lanes, mun);
+		bigint_batch mb = broadcast(mv, lanes, k + 1);
+
+		// q1 = a / b^(k-1) is a suffix of the rows
+		size_t q1n = n - k + 1;
+		bigint_batch q2(lanes, q1n + mun);
+		kernels->batch_mul(q2.data(), a.data() + (k - 1) * lanes, q1n, mub.data(), mun, lanes);
+
+		// q3 = q2 / b^(k+1), t = q3 * m
+		size_t q3n = q1n + mun - (k + 1);
+		bigint_batch t(lanes, q3n + k);
+		kernels->batch_mul(t.data(), q2.data() + (k + 1) * lanes, q3n, mb.data(), k, lanes);
+
+		// rem = (a - t) mod b^(k+1)
+		bigint_batch rem(lanes, k + 1);
+		memcpy(rem.data(), a.data(), lanes * std::min(n, k + 1) * sizeof(word_t));
+		kernels->batch_sub(rem.data(), rem.data(), t.data(), lanes, k + 1);
+
+		bigint_batch diff(lanes, k + 1);
+		std::vector<signed char> c(lanes);
+
+		for (int round = 0; round < 2; ++round)
+		{
+			kernels->batch_sub(diff.data(), rem.data(), mb.data(), lanes, k + 1);
+			kernels->batch_cmp(c.data(), rem.data(), mb.data(), lanes, k + 1);
+
+			for (size_t j = 0; j < k + 1; ++j)
+			{
+				word_t *rp = rem.data() + j * lanes;
+				const word_t *dp = diff.data() + j * lanes;
+
+				for (size_t l = 0; l < lanes; ++l)
+					rp[l] = (c[l] >= 0) ? dp[l] : rp[l];
+			}
+		}
+
+		memcpy(res.data(), rem.data(), lanes * k * sizeof(word_t));
+	}
+
+	r = std::move(res);
+}
+
+std::vector<signed char> bigint_batch::cmp(const bigint_batch &a, const bigint_batch &b)
+{
+	check_lanes(a, b);
+
+	std::vector<signed char> c(a.lanes);
+
+	if (a.nlimbs == b.nlimbs)
+	{
+		kernels->batch_cmp(c.data(), a.data(), b.data(), a.lanes, a.nlimbs);
+	}
+	else
+	{
+		// Zero-extend the shorter one
+		const bigint_batch &lo = (a.nlimbs < b.nlimbs) ? a : b;
+		bigint_batch ext(lo.lanes, std::max(a.nlimbs, b.nlimbs));
+		memcpy(ext.data(), lo.data(), lo.words.size() * sizeof(word_t));
+
+		if (&lo == &a)
+			kernels->batch_cmp(c.data(), ext.data(), b.data(), a.lanes, ext.nlimbs);
+		else
+			kernels->batch_cmp(c.data(), a.data(), ext.data(), a.lanes, ext.nlimbs);
+	}
+
+	return c;
+}
@@ -0,0 +1,634 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_factor.hpp"
+
+#include "kernels.hpp"
+#include "montgomery.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+// Primes below TRIAL_BOUND are divided out first, smaller cofactors are prime
+#define TRIAL_BOUND (1 << 14)
+// Steps of Pollard's rho between gcds and in total
+#define RHO_BATCH 128
+#define RHO_STEPS (1 << 16)
+#define PM1_B1 50000
+// Stage 1 bound of the first ECM round, it doubles every round
+#define ECM_B1 2000
+#define ECM_B2_RATIO 50
+#define ECM_CURVES 8
+// Giant step of ECM stage 2, 2 * 3 * 5 * 7 * 11
+#define ECM_GIANT 2310
+
+typedef std::vector<word_t> residue;
+
+/* Primes {{{ */
+
+static std::vector<bool> sieve(size_t bound)
+{
+	std::vector<bool> is_prime(bound, true);
+
+	for (size_t i = 0; i < std::min<size_t>(bound, 2); ++i)
+		is_prime[i] = false;
+
+	for (size_t i = 2; i * i < bound; ++i)
+	{
+		if (is_prime[i])
+		{
+			for (size_t j = i * i; j < bound; j += i)
+				is_prime[j] = false;
+		}
+	}
+
+	return is_prime;
+}
+
+static std::vector<word_t> primes_below(const std::vector<bool> &is_prime, size_t bound)
+{
+	std::vector<word_t> primes;
+
+	for (size_t i = 2; i < bound; ++i)
+	{
+		if (is_prime[i])
+			primes.push_back(i);
+	}
+
+	return primes;
+}
+
+static const std::vector<word_t> &small_primes()
+{
+	static const std::vector<word_t> primes = primes_below(sieve(TRIAL_BOUND), TRIAL_BOUND);
+	return primes;
+}
+
+static word_t mod_1(const bigint &n, word_t d)
+{
+	bigint_view v(n);
+	lword_t r = 0;
+
+	for (size_t i = v.word_count(); i-- > 0;)
+		r = ((r << WORD_BITN) | v.data()[i]) % d;
+
+	return r;
+}
+
+static size_t trailing_zeros(const bigint &n)
+{
+	bigint_view v(n);
+	size_t i = 0;
+
+	while (v.data()[i] == 0)
+		i++;
+
+	return i * WORD_BITN + CTZ(v.data()[i]);
+}
+
+bool is_probable_prime(const bigint &n, int rounds)
+{
+	const std::vector<word_t> &primes = small_primes();
+
+	if (n < TRIAL_BOUND)
+		return n >= 2 && std::binary_search(primes.begin(), primes.end(), n.to_uint());
+
+	for (size_t i = 0; i < 64; ++i)
+	{
+		if (mod_1(n, primes[i]) == 0)
+			return false;
+	}
+
+	// n - 1 = d * 2^s
+	bigint d = n - 1;
+	size_t s = trailing_zeros(d);
+	d = d.tdiv_q_2exp(s);
+
+	mont_ctx m(n);
+	residue zero(m.k, 0), minus_one(m.k), base(m.k), x(m.k), tp(m.scratch_size());
+	bigint_view dv(d);
+
+	m.sub(minus_one.data(), zero.data(), m.one.data());
+
+	for (size_t r = 0; r < static_cast<size_t>(std::max(rounds, 1)) && r < primes.size(); ++r)
+	{
+		m.to_mont(base.data(), primes[r], tp.data());
+		m.pow(x.data(), base.data(), dv.data(), dv.word_count(), tp.data());
+
+		if (x == m.one || x == minus_one)
+			continue;
+
+		size_t i = 1;
+
+		for (; i < s; ++i)
+		{
+			m.mul(x.data(), x.data(), x.data(), tp.data());
+
+			if (x == minus_one)
+				break;
+		}
+
+		if (i == s)
+			return false;
+	}
+
+	return true;
+}
+
+/* }}} Primes */
+
+/* Splitting {{{ */
+
+static bigint gcd_of(const residue &a, const bigint &n)
+{
+	return bigint(bigint_view(a.data(), a.size(), 0)).gcd(n);
+}
+
+static bigint proper_or_zero(const bigint &g, const bigint &n)
+{
+	return (g != 1 && g != n) ? g : bigint(0);
+}
+
+static bigint mod(const bigint &a, const bigint &n)
+{
+	bigint r = a % n;
+
+	if (r < 0)
+		r += n;
+
+	return r;
+}
+
+// Pollard's rho with Brent's cycle detection and x^2 + c, a proper factor or 0
+static bigint rho(const mont_ctx &m, const bigint &n, word_t c)
+{
+	residue cm(m.k), x(m.k), y(m.k), ys(m.k), q(m.one), d(m.k), tp(m.scratch_size());
+
+	m.to_mont(cm.data(), c, tp.data());
+	y = m.one;
+
+	auto step = [&](residue &v) {
+		m.mul(v.data(), v.data(), v.data(), tp.data());
+		m.add(v.data(), v.data(), cm.data());
+	};
+
+	bigint g = 1;
+	size_t steps = 0;
+
+	for (size_t r = 1; g == 1 && steps < RHO_STEPS; r *= 2)
+	{
+		x = y;
+
+		for (size_t i = 0; i < r; ++i)
+			step(y);
+
+		// The differences are multiplied together, one gcd per batch
+		for (size_t j = 0; j < r && g == 1; j += RHO_BATCH)
+		{
+			size_t batch = std::min<size_t>(RHO_BATCH, r - j);
+
+			ys = y;
+
+			for (size_t i = 0; i < batch; ++i)
+			{
+				step(y);
+				m.sub(d.data(), x.data(), y.data());
+				m.mul(q.data(), q.data(), d.data(), tp.data());
+			}
+
+			g = gcd_of(q, n);
+			steps += batch;
+		}
+
+		steps += r;
+	}
+
+	// The batch went past the factor, redo it one step at a time
+	if (g == n)
+	{
+		do
+		{
+			step(ys);
+			m.sub(d.data(), x.data(), ys.data());
+			g = gcd_of(d, n);
+		} while (g == 1);
+	}
+
+	return proper_or_zero(g, n);
+}
+
+// Pollard's p-1 stage 1, a proper factor or 0
+static bigint pm1(const mont_ctx &m, const bigint &n)
+{
+	static const std::vector<word_t> primes = primes_below(sieve(PM1_B1), PM1_B1);
+
+	residue a(m.k), tp(m.scratch_size());
+	word_t e = 1;
+
+	m.to_mont(a.data(), 2, tp.data());
+
+	// Prime powers up to PM1_B1, as few exponentiations by a word as possible
+	for (word_t p : primes)
+	{
+		lword_t q = p;
+
+		while (q * p <= PM1_B1)
+			q *= p;
+
+		if (e * q > WORD_MAX)
+		{
+			m.pow(a.data(), a.data(), &e, 1, tp.data());
+			e = 1;
+		}
+
+		e *= q;
+	}
+
+	m.pow(a.data(), a.data(), &e, 1, tp.data());
+	m.sub(a.data(), a.data(), m.one.data());
+
+	return proper_or_zero(gcd_of(a, n), n);
+}
+
+/*
+ * x-only arithmetic on a Montgomery curve B * y^2 = x^3 + A * x^2 + x.
+ * Points are (X : Z) pairs in one buffer, X in the low k words.
+ */
+struct ecm_curve
+{
+	const mont_ctx &m;
+	residue a24;  // (A + 2) / 4
+	residue t1, t2, t3, t4, tp;
+	residue l0, l1;
+
+	explicit ecm_curve(const mont_ctx &m)
+		: m(m)
+		, a24(m.k)
+		, t1(m.k)
+		, t2(m.k)
+		, t3(m.k)
+		, t4(m.k)
+		, tp(m.scratch_size())
+		, l0(2 * m.k)
+		, l1(2 * m.k)
+	{}
+
+	word_t *X(residue &p) const { return p.data(); }
+	word_t *Z(residue &p) const { return p.data() + m.k; }
+	const word_t *X(const residue &p) const { return p.data(); }
+	const word_t *Z(const residue &p) const { return p.data() + m.k; }
+
+	// r = 2p
+	void dbl(residue &r, const residue &p)
+	{
+		m.add(t1.data(), X(p), Z(p));
+		m.mul(t1.data(), t1.data(), t1.data(), tp.data());
+		m.sub(t2.data(), X(p), Z(p));
+		m.mul(t2.data(), t2.data(), t2.data(), tp.data());
+		m.sub(t3.data(), t1.data(), t2.data());
+		m.mul(X(r), t1.data(), t2.data(), tp.data());
+		m.mul(t4.data(), a24.data(), t3.data(), tp.data());
+		m.add(t4.data(), t4.data(), t2.data());
+		m.mul(Z(r), t3.data(), t4.data(), tp.data());
+	}
+
+	// r = p + q given d = p - q, r may be any of them
+	void add(residue &r, const residue &p, const residue &q, const residue &d)
+	{
+		m.sub(t1.data(), X(p), Z(p));
+		m.add(t2.data(), X(q), Z(q));
+		m.mul(t1.data(), t1.data(), t2.data(), tp.data());
+		m.add(t2.data(), X(p), Z(p));
+		m.sub(t3.data(), X(q), Z(q));
+		m.mul(t2.data(), t2.data(), t3.data(), tp.data());
+
+		m.add(t3.data(), t1.data(), t2.data());
+		m.mul(t3.data(), t3.data(), t3.data(), tp.data());
+		m.sub(t4.data(), t1.data(), t2.data());
+		m.mul(t4.data(), t4.data(), t4.data(), tp.data());
+
+		m.mul(t3.data(), t3.data(), Z(d), tp.data());
+		m.mul(Z(r), t4.data(), X(d), tp.data());
+		std::copy(t3.begin(), t3.end(), X(r));
+	}
+
+	// r = e * p by the Montgomery ladder, e > 0
+	void ladder(residue &r, const residue &p, lword_t e)
+	{
+		int top = 0;
+
+		while (e >> (top + 1))
+			top++;
+
+		l0 = p;
+		dbl(l1, p);
+
+		for (int i = top - 1; i >= 0; --i)
+		{
+			if ((e >> i) & 1)
+			{
+				add(l0, l0, l1, p);
+				dbl(l1, l1);
+			}
+			else
+			{
+				add(l1, l0, l1, p);
+				dbl(l0, l0);
+			}
+		}
+
+		r = l0;
+	}
+};
+
+struct ecm_round
+{
+	size_t b1;
+	size_t b2;
+	std::vector<bool> is_prime;  // Below b2 + ECM_GIANT
+	std::vector<word_t> primes;  // Up to b1
+};
+
+// One curve with Suyama's parametrization by sigma, a proper factor or 0
+static bigint ecm(const mont_ctx &m, const bigint &n, size_t sigma, const ecm_round &round,
+                  const std::atomic<bool> &found)
+{
+	ecm_curve curve(m);
+	size_t k = m.k;
+
+	// u = sigma^2 - 5, v = 4 * sigma, x0 = u^3 / v^3, (A + 2) / 4 = (v - u)^3 * (3 * u + v) / (16 * u^3 * v)
+	bigint s = sigma;
+	bigint u = mod(s * s - 5, n), v = mod(s * 4, n);
+	bigint u3 = u * u * u % n, v3 = v * v * v % n;
+	bigint vu = mod(v - u, n);
+	bigint num = vu * vu % n * vu % n * ((u * 3 + v) % n) % n;
+	bigint den = u3 * v % n * 16 % n;
+
+	bigint g = den.gcd(n);
+
+	if (g != 1)
+		return proper_or_zero(g, n);
+
+	bigint inv = den.invmod(n);
+
+	residue q(2 * k), tp(m.scratch_size());
+
+	m.to_mont(curve.a24.data(), num * inv % n, tp.data());
+	m.to_mont(curve.X(q), u3, tp.data());
+	m.to_mont(curve.Z(q), v3, tp.data());
+
+	// Stage 1: q = M * q with M the product of the prime powers up to b1
+	for (size_t i = 0; i < round.primes.size(); ++i)
+	{
+		lword_t p = round.primes[i], e = p;
+
+		while (e * p <= round.b1)
+			e *= p;
+
+		curve.ladder(q, q, e);
+
+		if (i % 64 == 0 && found)
+			return 0;
+	}
+
+	g = gcd_of(residue(curve.Z(q), curve.Z(q) + k), n);
+
+	if (g != 1)
+		return proper_or_zero(g, n);
+
+	// Stage 2: one more prime p up to b2 with p = c * ECM_GIANT +- j, j odd and coprime to ECM_GIANT.
+	// Then x(c * ECM_GIANT * q) = x(j * q), so the products of the cross differences reveal the factor.
+	const size_t half = ECM_GIANT / 2;
+
+	std::vector<residue> baby;
+	std::vector<size_t> baby_j;
+	residue q2(2 * k), prev(q), cur(q), next(2 * k);
+
+	curve.dbl(q2, q);
+
+	for (size_t j = 1; j < half; j += 2)
+	{
+		if (j % 3 != 0 && j % 5 != 0 && j % 7 != 0 && j % 11 != 0)
+		{
+			baby.push_back(cur);
+			baby_j.push_back(j);
+		}
+
+		curve.add(next, cur, q2, prev);
+		prev.swap(cur);
+		cur.swap(next);
+	}
+
+	// The ranges of consecutive c are contiguous, so none of the primes just above b1 is skipped
+	size_t c = std::max<size_t>(1, round.b1 / ECM_GIANT);
+	residue giant(2 * k), r(2 * k), rp(2 * k);
+	residue acc(m.one), t(k), t2(k);
+
+	curve.ladder(giant, q, ECM_GIANT);
+	curve.ladder(r, giant, c);
+
+	if (c > 1)
+		curve.ladder(rp, giant, c - 1);
+
+	for (; c * ECM_GIANT - half <= round.b2; ++c)
+	{
+		size_t center = c * ECM_GIANT;
+
+		for (size_t i = 0; i < baby.size(); ++i)
+		{
+			size_t j = baby_j[i];
+
+			if (!round.is_prime[center - j] && !round.is_prime[center + j])
+				continue;
+
+			m.mul(t.data(), curve.X(r), curve.Z(baby[i]), tp.data());
+			m.mul(t2.data(), curve.X(baby[i]), curve.Z(r), tp.data());
+			m.sub(t.data(), t.data(), t2.data());
+			m.mul(acc.data(), acc.data(), t.data(), tp.data());
+		}
+
+		// The differential add needs r - giant, which is the point at infinity for c = 1
+		if (c == 1)
+			curve.dbl(rp, r);
+		else
+			curve.add(rp, r, giant, rp);
+
+		rp.swap(r);
+
+		if (c % 16 == 0 && found)
+			return 0;
+	}
+
+	return proper_or_zero(gcd_of(acc, n), n);
+}
+
+// Rounds of curves with growing bounds until one of them finds a factor
+static bigint ecm_factor(const bigint &n, bigint_executor *ex)
+{
+	mont_ctx m(n);
+	size_t curves = ECM_CURVES;
+	size_t sigma = 6;
+
+	if (ex != nullptr)
+		curves = (curves + ex->threads() - 1) / ex->threads() * ex->threads();
+
+	for (size_t b1 = ECM_B1;; b1 *= 2)
+	{
+		ecm_round round;
+
+		round.b1 = b1;
+		round.b2 = b1 * ECM_B2_RATIO;
+		round.is_prime = sieve(round.b2 + ECM_GIANT);
+		round.primes = primes_below(round.is_prime, b1 + 1);
+
+		std::atomic<bool> found(false);
+		std::mutex lock;
+		bigint factor;
+
+		auto run_curve = [&](size_t i) {
+			if (found)
+				return;
+
+			bigint f = ecm(m, n, sigma + i, round, found);
+
+			if (f != 0)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+
+				if (!found)
+				{
+					factor = f;
+					found = true;
+				}
+			}
+		};
+
+		if (ex != nullptr)
+		{
+			ex->run(curves, run_curve, [](size_t) -> size_t { return 1; });
+		}
+		else
+		{
+			for (size_t i = 0; i < curves && !found; ++i)
+				run_curve(i);
+		}
+
+		if (found)
+			return factor;
+
+		sigma += curves;
+	}
+}
+
+// A proper factor of a composite n without small factors
+static bigint find_factor(const bigint &n, bigint_executor *ex)
+{
+	bigint r = n.sqrt();
+
+	if (r * r == n)
+		return r;
+
+	mont_ctx m(n);
+	bigint f = rho(m, n, 1);
+
+	if (f == 0)
+		f = pm1(m, n);
+
+	if (f == 0)
+		f = ecm_factor(n, ex);
+
+	return f;
+}
+
+static void split(const bigint &n, bigint_executor *ex, std::vector<bigint> &factors)
+{
+	if (n < static_cast<lword_t>(TRIAL_BOUND) * TRIAL_BOUND || is_probable_prime(n))
+	{
+		factors.push_back(n);
+		return;
+	}
+
+	bigint f = find_factor(n, ex);
+
+	split(f, ex, factors);
+	split(n.divexact(f), ex, factors);
+}
+
+// Divides out the primes below TRIAL_BOUND, returns the cofactor
+static bigint trial_divide(bigint n, std::vector<bigint> &factors)
+{
+	const std::vector<word_t> &primes = small_primes();
+
+	size_t twos = trailing_zeros(n);
+	factors.insert(factors.end(), twos, 2);
+	n = n.tdiv_q_2exp(twos);
+
+	for (size_t i = 1; i < primes.size();)
+	{
+		if (n < static_cast<lword_t>(primes[i]) * primes[i])
+			break;
+
+		// One remainder by a product of primes fitting in a word, then one per prime
+		lword_t prod = primes[i];
+		size_t j = i + 1;
+
+		while (j < primes.size() && prod * primes[j] <= WORD_MAX)
+			prod *= primes[j++];
+
+		word_t rem = mod_1(n, prod);
+
+		for (; i < j; ++i)
+		{
+			if (rem % primes[i] != 0)
+				continue;
+
+			do
+			{
+				factors.push_back(primes[i]);
+				n = n.divexact(primes[i]);
+			} while (mod_1(n, primes[i]) == 0);
+		}
+	}
+
+	return n;
+}
+
+std::vector<bigint> factorize(const bigint &n, bigint_executor *ex)
+{
+	if (n == 0)
+		throw bigint_exception("can't factorize zero!");
+
+	std::vector<bigint> factors;
+	bigint rest = trial_divide(n.abs(), factors);
+
+	if (rest != 1)
+		split(rest, ex, factors);
+
+	std::sort(factors.begin(), factors.end());
+
+	return factors;
+}
+
+/* }}} Splitting */
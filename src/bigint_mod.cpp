@@ -0,0 +1,414 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_mod.hpp"
+
+#include "kernels.hpp"
+#include "montgomery.hpp"
+
+#include <algorithm>
+
+struct bigint_mod_ctx::impl
+{
+	bigint modulus;
+	mont_ctx m;
+
+	explicit impl(const bigint &modulus)
+		: modulus(modulus)
+		, m(modulus)
+	{}
+};
+
+// Per thread, so that modints of one context can be used from many threads
+static word_t *scratch(size_t n)
+{
+	static thread_local std::vector<word_t> tp;
+
+	if (tp.size() < n)
+		tp.resize(n);
+
+	return tp.data();
+}
+
+/* Context {{{ */
+
+bigint_mod_ctx::bigint_mod_ctx(const bigint &modulus)
+	: p(new impl(modulus))
+{}
+
+bigint_mod_ctx::~bigint_mod_ctx() = default;
+
+const bigint &bigint_mod_ctx::modulus() const
+{
+	return p->modulus;
+}
+
+size_t bigint_mod_ctx::limbs() const
+{
+	return p->m.k;
+}
+
+modint bigint_mod_ctx::operator()(const bigint &x) const
+{
+	modint res(this);
+	bigint r = x % p->modulus;
+
+	if (r < 0)
+		r += p->modulus;
+
+	p->m.to_mont(res.limbs.data(), r, scratch(p->m.scratch_size()));
+
+	return res;
+}
+
+modint bigint_mod_ctx::zero() const
+{
+	return modint(this);
+}
+
+modint bigint_mod_ctx::one() const
+{
+	modint res(this);
+	res.limbs = p->m.one;
+	return res;
+}
+
+/* }}} Context */
+
+/* Values {{{ */
+
+modint::modint()
+	: ctx(nullptr)
+{}
+
+modint::modint(const bigint_mod_ctx *ctx)
+	: ctx(ctx)
+	, limbs(ctx->p->m.k, 0)
+{}
+
+void modint::check(const modint &rhs) const
+{
+	if (ctx == nullptr || ctx != rhs.ctx)
+		throw bigint_exception("operands belong to different contexts!");
+}
+
+bigint modint::value() const
+{
+	check(*this);
+
+	return ctx->p->m.from_mont(limbs.data(), scratch(ctx->p->m.scratch_size()));
+}
+
+const bigint_mod_ctx *modint::context() const
+{
+	return ctx;
+}
+
+modint &modint::operator+=(const modint &rhs)
+{
+	check(rhs);
+	ctx->p->m.add(limbs.data(), limbs.data(), rhs.limbs.data());
+	return *this;
+}
+
+modint &modint::operator-=(const modint &rhs)
+{
+	check(rhs);
+	ctx->p->m.sub(limbs.data(), limbs.data(), rhs.limbs.data());
+	return *this;
+}
+
+modint &modint::operator*=(const modint &rhs)
+{
+	check(rhs);
+
+	const mont_ctx &m = ctx->p->m;
+	m.mul(limbs.data(), limbs.data(), rhs.limbs.data(), scratch(m.scratch_size()));
+
+	return *this;
+}
+
+modint modint::operator+(const modint &rhs) const
+{
+	modint res = *this;
+	return res += rhs;
+}
+
+modint modint::operator-(const modint &rhs) const
+{
+	modint res = *this;
+	return res -= rhs;
+}
+
+modint modint::operator*(const modint &rhs) const
+{
+	modint res = *this;
+	return res *= rhs;
+}
+
+modint modint::operator-() const
+{
+	check(*this);
+
+	modint res(ctx);
+	ctx->p->m.neg(res.limbs.data(), limbs.data());
+
+	return res;
+}
+
+bool modint::operator==(const modint &rhs) const
+{
+	return ctx == rhs.ctx && limbs == rhs.limbs;
+}
+
+bool modint::operator!=(const modint &rhs) const
+{
+	return !(*this == rhs);
+}
+
+bool modint::is_zero() const
+{
+	return std::all_of(limbs.begin(), limbs.end(), [](word_t w) { return w == 0; });
+}
+
+modint modint::inverse() const
+{
+	check(*this);
+
+	return (*ctx)(value().invmod(ctx->p->modulus));
+}
+
+modint modint::pow(const bigint &exp) const
+{
+	check(*this);
+
+	if (exp < 0)
+		return inverse().pow(-exp);
+
+	const mont_ctx &m = ctx->p->m;
+	modint res(ctx);
+	bigint_view e(exp);
+
+	m.pow(res.limbs.data(), limbs.data(), e.data(), e.word_count(), scratch(m.scratch_size()));
+
+	return res;
+}
+
+/* }}} Values */
+
+/* Multi-exponentiation {{{ */
+
+// Pippenger's buckets pay off from this many bases
+#define PIPPENGER_THRESHOLD 32
+
+// Bits [pos, pos + w) of the magnitude
+static unsigned window(const bigint_view &e, size_t pos, unsigned w)
+{
+	size_t i = pos / WORD_BITN;
+	unsigned shift = pos % WORD_BITN;
+
+	if (i >= e.word_count())
+		return 0;
+
+	lword_t bits = e.data()[i] >> shift;
+
+	if (shift + w > WORD_BITN && i + 1 < e.word_count())
+		bits |= static_cast<lword_t>(e.data()[i + 1]) << (WORD_BITN - shift);
+
+	return bits & ((1u << w) - 1);
+}
+
+modint bigint_mod_ctx::multi_pow(const std::vector<modint> &bases, const std::vector<bigint> &exps) const
+{
+	if (bases.size() != exps.size())
+		throw bigint_exception("counts of bases and exponents differ!");
+
+	size_t n = bases.size();
+	size_t bits = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (bases[i].ctx != this)
+			throw bigint_exception("operands belong to different contexts!");
+
+		if (exps[i] < 0)
+			throw bigint_exception("exponent must be non-negative!");
+
+		bits = std::max(bits, exps[i].bit_length());
+	}
+
+	const mont_ctx &m = p->m;
+	size_t k = m.k;
+
+	std::vector<bigint_view> ev(exps.begin(), exps.end());
+	modint acc = one();
+	word_t *rp = acc.limbs.data();
+	word_t *tp = scratch(m.scratch_size());
+
+	// Squarings of the accumulator are skipped while it's one
+	bool started = false;
+
+	if (n < PIPPENGER_THRESHOLD)
+	{
+		// Straus: g^1 ... g^(2^w - 1) for every base, one chain of squarings for all of them
+		unsigned w = (bits <= 64) ? 2 : (bits <= 512) ? 4 : 5;
+		size_t entries = (static_cast<size_t>(1) << w) - 1;
+		std::vector<word_t> table(n * entries * k);
+
+		auto entry = [&](size_t i, unsigned d) { return table.data() + (i * entries + d - 1) * k; };
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			std::copy(bases[i].limbs.begin(), bases[i].limbs.end(), entry(i, 1));
+
+			for (unsigned d = 2; d <= entries; ++d)
+				m.mul(entry(i, d), entry(i, d - 1), entry(i, 1), tp);
+		}
+
+		for (size_t win = (bits + w - 1) / w; win-- > 0;)
+		{
+			for (unsigned j = 0; started && j < w; ++j)
+				m.mul(rp, rp, rp, tp);
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				unsigned d = window(ev[i], win * w, w);
+
+				if (d != 0)
+				{
+					m.mul(rp, rp, entry(i, d), tp);
+					started = true;
+				}
+			}
+		}
+	}
+	else
+	{
+		// Pippenger: every window sorts the bases into buckets by their digit,
+		// running products then raise bucket d to the d-th power
+		unsigned c = 1;
+
+		while ((static_cast<size_t>(1) << (c + 3)) < n)
+			c++;
+
+		size_t nbuckets = (static_cast<size_t>(1) << c) - 1;
+		std::vector<word_t> buckets(nbuckets * k), running(k), total(k);
+		std::vector<bool> used(nbuckets);
+
+		auto bucket = [&](unsigned d) { return buckets.data() + (d - 1) * k; };
+
+		for (size_t win = (bits + c - 1) / c; win-- > 0;)
+		{
+			for (unsigned j = 0; started && j < c; ++j)
+				m.mul(rp, rp, rp, tp);
+
+			std::fill(used.begin(), used.end(), false);
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				unsigned d = window(ev[i], win * c, c);
+
+				if (d == 0)
+					continue;
+
+				if (used[d - 1])
+					m.mul(bucket(d), bucket(d), bases[i].limbs.data(), tp);
+				else
+					std::copy(bases[i].limbs.begin(), bases[i].limbs.end(), bucket(d));
+
+				used[d - 1] = true;
+			}
+
+			bool have_running = false, have_total = false;
+
+			for (unsigned d = nbuckets; d >= 1; --d)
+			{
+				if (used[d - 1])
+				{
+					if (have_running)
+						m.mul(running.data(), running.data(), bucket(d), tp);
+					else
+						std::copy(bucket(d), bucket(d) + k, running.begin());
+
+					have_running = true;
+				}
+
+				if (have_running)
+				{
+					if (have_total)
+						m.mul(total.data(), total.data(), running.data(), tp);
+					else
+						total = running;
+
+					have_total = true;
+				}
+			}
+
+			if (have_total)
+			{
+				m.mul(rp, rp, total.data(), tp);
+				started = true;
+			}
+		}
+	}
+
+	return acc;
+}
+
+std::vector<modint> bigint_mod_ctx::batch_inverse(const std::vector<modint> &values) const
+{
+	size_t n = values.size();
+	std::vector<modint> res(n);
+
+	if (n == 0)
+		return res;
+
+	if (values[0].ctx != this)
+		throw bigint_exception("operands belong to different contexts!");
+
+	// Prefix products first, res[i] = values[0] * ... * values[i]
+	res[0] = values[0];
+
+	for (size_t i = 1; i < n; ++i)
+	{
+		res[i] = res[i - 1];
+		res[i] *= values[i];
+	}
+
+	// Then inv = (values[0] * ... * values[i])^-1 on the way back
+	modint inv = res[n - 1].inverse();
+
+	for (size_t i = n - 1; i > 0; --i)
+	{
+		res[i] = res[i - 1];
+		res[i] *= inv;
+		inv *= values[i];
+	}
+
+	res[0] = inv;
+
+	return res;
+}
+
+/* }}} Multi-exponentiation */
@@ -0,0 +1,292 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+// Chunks per thread, so that stealing can even out bad estimates
+#define CHUNKS_PER_THREAD 8
+
+// Set while running items, nested runs are serial
+static thread_local bool in_run = false;
+
+struct chunk_queue
+{
+	std::mutex lock;
+	std::deque<std::pair<size_t, size_t>> chunks;
+};
+
+struct bigint_executor::impl
+{
+	std::vector<std::thread> workers;
+	std::mutex run_lock;  // One run at a time
+
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation = 0;
+	size_t busy = 0;  // Workers inside work()
+	bool stop = false;
+
+	/* Current run, set up under lock while busy == 0 */
+	const std::function<void(size_t)> *fn = nullptr;
+	std::unique_ptr<chunk_queue[]> queues;
+	size_t nqueues = 0;
+	std::atomic<bool> failed;
+	std::exception_ptr error;
+
+	void work(size_t self);
+	void worker_loop(size_t self);
+};
+
+// Own chunks are taken from the front, stolen ones from the back
+void bigint_executor::impl::work(size_t self)
+{
+	bool saved = in_run;
+	in_run = true;
+
+	for (;;)
+	{
+		std::pair<size_t, size_t> c;
+		bool found = false;
+
+		for (size_t k = 0; k < nqueues && !found; ++k)
+		{
+			chunk_queue &q = queues[(self + k) % nqueues];
+			std::lock_guard<std::mutex> guard(q.lock);
+
+			if (q.chunks.empty())
+				continue;
+
+			if (k == 0)
+			{
+				c = q.chunks.front();
+				q.chunks.pop_front();
+			}
+			else
+			{
+				c = q.chunks.back();
+				q.chunks.pop_back();
+			}
+
+			found = true;
+		}
+
+		if (!found)
+			break;
+
+		if (failed.load(std::memory_order_relaxed))
+			continue;
+
+		try
+		{
+			for (size_t i = c.first; i < c.second; ++i)
+				(*fn)(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			if (!failed.exchange(true))
+				error = std::current_exception();
+		}
+	}
+
+	in_run = saved;
+}
+
+void bigint_executor::impl::worker_loop(size_t self)
+{
+	uint64_t seen = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [&]() { return stop || generation != seen; });
+
+			if (stop)
+				return;
+
+			seen = generation;
+			busy++;
+		}
+
+		work(self);
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			busy--;
+		}
+
+		done.notify_all();
+	}
+}
+
+bigint_executor::bigint_executor(size_t threads)
+	: p(new impl)
+{
+	if (threads == 0)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+
+	p->failed = false;
+	p->nqueues = threads;
+	p->queues.reset(new chunk_queue[threads]);
+
+	for (size_t i = 1; i < threads; ++i)
+		p->workers.emplace_back(&impl::worker_loop, p.get(), i);
+}
+
+bigint_executor::~bigint_executor()
+{
+	{
+		std::lock_guard<std::mutex> guard(p->lock);
+		p->stop = true;
+	}
+
+	p->wake.notify_all();
+
+	for (auto &t : p->workers)
+		t.join();
+}
+
+size_t bigint_executor::threads() const
+{
+	return p->nqueues;
+}
+
+void bigint_executor::run(size_t n, const std::function<void(size_t)> &fn, const std::function<size_t(size_t)> &cost)
+{
+	if (n == 0)
+		return;
+
+	if (p->nqueues == 1 || n == 1 || in_run)
+	{
+		for (size_t i = 0; i < n; ++i)
+			fn(i);
+
+		return;
+	}
+
+	std::lock_guard<std::mutex> run_guard(p->run_lock);
+
+	std::vector<size_t> costs(n);
+	size_t total = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		costs[i] = cost(i) + 1;
+		total += costs[i];
+	}
+
+	size_t target = std::max<size_t>(1, total / (p->nqueues * CHUNKS_PER_THREAD));
+	std::vector<std::pair<size_t, size_t>> chunks;
+	size_t start = 0, acc = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		acc += costs[i];
+
+		if (acc >= target || i == n - 1)
+		{
+			chunks.push_back(std::make_pair(start, i + 1));
+			start = i + 1;
+			acc = 0;
+		}
+	}
+
+	{
+		std::unique_lock<std::mutex> guard(p->lock);
+		p->done.wait(guard, [&]() { return p->busy == 0; });
+
+		// Contiguous runs of chunks per thread
+		for (size_t j = 0; j < chunks.size(); ++j)
+			p->queues[j * p->nqueues / chunks.size()].chunks.push_back(chunks[j]);
+
+		p->fn = &fn;
+		p->failed = false;
+		p->error = nullptr;
+		p->generation++;
+	}
+
+	p->wake.notify_all();
+	p->work(0);
+
+	std::exception_ptr error;
+
+	{
+		std::unique_lock<std::mutex> guard(p->lock);
+		p->done.wait(guard, [&]() { return p->busy == 0; });
+
+		p->fn = nullptr;
+		error = p->error;
+		p->error = nullptr;
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+bigint_executor &bigint_executor::shared()
+{
+	static bigint_executor ex;
+	return ex;
+}
+
+std::vector<bigint> parallel_powmod(const std::vector<bigint> &bases, const bigint &exp, const bigint &mod)
+{
+	std::vector<bigint> out(bases.size());
+
+	parallel_transform(
+		bases.begin(), bases.end(), out.begin(), [&](const bigint &b) { return b.powmod(exp, mod); },
+		[&](const bigint &b) -> size_t { return bigint_cost(b) + bigint_cost(mod) * exp.bit_length(); });
+
+	return out;
+}
+
+std::vector<std::string> parallel_to_string(const std::vector<bigint> &values, int base)
+{
+	std::vector<std::string> out(values.size());
+
+	parallel_transform(values.begin(), values.end(), out.begin(),
+	                   [&](const bigint &v) { return v.to_string(base); });
+
+	return out;
+}
+
+std::vector<bigint> parallel_parse(const std::vector<std::string> &strings)
+{
+	std::vector<bigint> out(strings.size());
+
+	parallel_transform(strings.begin(), strings.end(), out.begin(), [](const std::string &s) { return bigint(s); });
+
+	return out;
+}
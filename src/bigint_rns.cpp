@@ -0,0 +1,313 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_rns.hpp"
+
+#include "kernels.hpp"
+
+#include <algorithm>
+
+// Residues per item handed to an executor by the elementwise operations
+#define RNS_CHUNK 4096
+// Primes from which from_rns goes through the product tree instead of Garner's algorithm
+#define RNS_TREE_THRESHOLD 96
+
+static uint32_t mulmod(uint32_t a, uint32_t b, uint32_t m)
+{
+	return static_cast<uint64_t>(a) * b % m;
+}
+
+static uint32_t powmod(uint32_t a, uint32_t e, uint32_t m)
+{
+	uint32_t r = 1;
+
+	for (; e != 0; e >>= 1)
+	{
+		if (e & 1)
+			r = mulmod(r, a, m);
+
+		a = mulmod(a, a, m);
+	}
+
+	return r;
+}
+
+// Miller-Rabin with bases 2, 7 and 61 is exact below 2^32
+static bool is_prime(uint32_t n)
+{
+	uint32_t d = n - 1;
+	int s = 0;
+
+	for (; (d & 1) == 0; d >>= 1)
+		s++;
+
+	for (uint32_t a : {2, 7, 61})
+	{
+		uint32_t x = powmod(a, d, n);
+
+		if (x == 1 || x == n - 1)
+			continue;
+
+		int i = 1;
+
+		for (; i < s; ++i)
+		{
+			x = mulmod(x, x, n);
+
+			if (x == n - 1)
+				break;
+		}
+
+		if (i == s)
+			return false;
+	}
+
+	return true;
+}
+
+// The largest primes below 2^31, every one above 2^30
+static std::vector<uint32_t> rns_primes(size_t bits)
+{
+	std::vector<uint32_t> primes;
+	size_t count = (bits + 1) / 30 + 1;
+
+	for (uint32_t n = 0x7FFFFFFF; primes.size() < count; n -= 2)
+	{
+		if (is_prime(n))
+			primes.push_back(n);
+	}
+
+	return primes;
+}
+
+static std::vector<bigint> to_bigints(const std::vector<uint32_t> &v)
+{
+	return std::vector<bigint>(v.begin(), v.end());
+}
+
+// fn(i0, i1) for chunks [i0, i1) of [0, n)
+static void for_each_chunk(bigint_executor *ex, size_t n, const std::function<void(size_t, size_t)> &fn)
+{
+	size_t chunks = (n + RNS_CHUNK - 1) / RNS_CHUNK;
+
+	if (ex == nullptr || chunks <= 1)
+	{
+		fn(0, n);
+		return;
+	}
+
+	ex->run(
+		chunks, [&](size_t c) { fn(c * RNS_CHUNK, std::min(n, (c + 1) * RNS_CHUNK)); },
+		[](size_t) -> size_t { return RNS_CHUNK; });
+}
+
+bigint_rns::bigint_rns(size_t bits)
+	: p(rns_primes(bits))
+	, mu(p.size())
+	, tree(to_bigints(p))
+	, half(tree.product() >> 1)
+{
+	size_t k = p.size();
+
+	for (size_t i = 0; i < k; ++i)
+		mu[i] = (1ULL << 62) / p[i];
+
+	if (k < RNS_TREE_THRESHOLD)
+	{
+		garner.resize(k);
+
+		for (size_t i = 0; i < k; ++i)
+		{
+			uint32_t prod = 1;
+
+			for (size_t j = 0; j < i; ++j)
+				prod = barrett_reduce(static_cast<uint64_t>(prod) * p[j], p[i], mu[i]);
+
+			garner[i] = powmod(prod, p[i] - 2, p[i]);
+		}
+	}
+	else
+	{
+		// M % p^2 = p * (M / p % p)
+		std::vector<bigint> rems = tree.remainders(modulus(), true);
+		crt.resize(k);
+
+		for (size_t i = 0; i < k; ++i)
+			crt[i] = powmod((rems[i] / p[i]).to_uint(), p[i] - 2, p[i]);
+	}
+}
+
+void bigint_rns::check(const residues &a) const
+{
+	if (a.size() != p.size())
+		throw bigint_exception("residues don't match the RNS context!");
+}
+
+bigint_rns::residues bigint_rns::to_rns(const bigint &x, bigint_executor *ex) const
+{
+	std::vector<bigint> rems = tree.remainders(x.abs(), false, ex);
+	residues r(p.size());
+
+	for (size_t i = 0; i < p.size(); ++i)
+	{
+		r[i] = rems[i].to_uint();
+
+		if (x < 0 && r[i] != 0)
+			r[i] = p[i] - r[i];
+	}
+
+	return r;
+}
+
+bigint bigint_rns::from_rns(const residues &r, bigint_executor *ex) const
+{
+	check(r);
+
+	bigint x = (p.size() < RNS_TREE_THRESHOLD) ? garner_combine(r) : tree_combine(r, ex);
+
+	if (x > half)
+		x -= modulus();
+
+	return x;
+}
+
+/*
+ * Garner: the mixed-radix digits v[i] with x = v[0] + v[1] * p[0] + v[2] * p[0] * p[1] + ...
+ * come from evaluating the digits found so far modulo p[i]; then Horner's rule.
+ */
+bigint bigint_rns::garner_combine(const residues &r) const
+{
+	size_t k = p.size();
+	std::vector<uint32_t> v(k);
+
+	for (size_t i = 0; i < k; ++i)
+	{
+		uint32_t t = 0;
+
+		for (size_t j = i; j-- > 0;)
+			t = barrett_reduce(static_cast<uint64_t>(t) * p[j] + v[j], p[i], mu[i]);
+
+		uint32_t d = (r[i] >= t) ? r[i] - t : r[i] + p[i] - t;
+		v[i] = barrett_reduce(static_cast<uint64_t>(d) * garner[i], p[i], mu[i]);
+	}
+
+	bigint x = v[k - 1];
+
+	for (size_t i = k - 1; i-- > 0;)
+	{
+		x *= p[i];
+		x += v[i];
+	}
+
+	return x;
+}
+
+/*
+ * CRT up the product tree: x = sum of c[i] * M / p[i] mod M with c[i] = r[i] * (M / p[i])^-1 mod p[i].
+ * A node holds the sum over its values of c[i] * P / p[i], P being its product, so the parent of
+ * nodes (u, P) and (w, Q) holds u * Q + w * P.
+ */
+bigint bigint_rns::tree_combine(const residues &r, bigint_executor *ex) const
+{
+	residues c(p.size());
+	kernels->mulmod_n(c.data(), r.data(), crt.data(), p.data(), mu.data(), p.size());
+
+	std::vector<bigint> v(c.begin(), c.end());
+
+	for (size_t j = 1; j < tree.levels(); ++j)
+	{
+		const std::vector<bigint> &below = tree.level(j - 1);
+		std::vector<bigint> above(tree.level(j).size());
+
+		auto fn = [&](size_t i) {
+			if (2 * i + 1 < below.size())
+				above[i] = v[2 * i] * below[2 * i + 1] + v[2 * i + 1] * below[2 * i];
+			else
+				above[i] = std::move(v[2 * i]);
+		};
+
+		if (ex != nullptr)
+			ex->run(above.size(), fn, [&](size_t i) { return 2 * below[2 * i].size(); });
+		else
+		{
+			for (size_t i = 0; i < above.size(); ++i)
+				fn(i);
+		}
+
+		v = std::move(above);
+	}
+
+	return v[0] % modulus();
+}
+
+// Below 2^32 since the primes are below 2^31, min() picks the reduced value without a branch
+bigint_rns::residues bigint_rns::add(const residues &a, const residues &b, bigint_executor *ex) const
+{
+	check(a);
+	check(b);
+
+	residues r(p.size());
+
+	for_each_chunk(ex, p.size(), [&](size_t i0, size_t i1) {
+		for (size_t i = i0; i < i1; ++i)
+		{
+			uint32_t s = a[i] + b[i];
+			r[i] = std::min(s, s - p[i]);
+		}
+	});
+
+	return r;
+}
+
+bigint_rns::residues bigint_rns::sub(const residues &a, const residues &b, bigint_executor *ex) const
+{
+	check(a);
+	check(b);
+
+	residues r(p.size());
+
+	for_each_chunk(ex, p.size(), [&](size_t i0, size_t i1) {
+		for (size_t i = i0; i < i1; ++i)
+		{
+			uint32_t d = a[i] - b[i];
+			r[i] = std::min(d, d + p[i]);
+		}
+	});
+
+	return r;
+}
+
+bigint_rns::residues bigint_rns::mul(const residues &a, const residues &b, bigint_executor *ex) const
+{
+	check(a);
+	check(b);
+
+	residues r(p.size());
+
+	for_each_chunk(ex, p.size(), [&](size_t i0, size_t i1) {
+		kernels->mulmod_n(r.data() + i0, a.data() + i0, b.data() + i0, p.data() + i0, mu.data() + i0, i1 - i0);
+	});
+
+	return r;
+}
@@ -0,0 +1,134 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_series.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// Ranges per thread when the executor is used, later terms are more expensive
+#define SPLIT_CHUNKS_PER_THREAD 4
+
+static bigint_pqt join(const bigint_pqt &l, const bigint_pqt &r)
+{
+	bigint_pqt res;
+
+	res.T = l.T * r.Q;
+	res.T.addmul(l.P, r.T);
+	res.P = l.P * r.P;
+	res.Q = l.Q * r.Q;
+
+	return res;
+}
+
+static bigint_pqt split(const bigint_term &p, const bigint_term &q, const bigint_term &a, size_t n1, size_t n2)
+{
+	if (n2 - n1 == 1)
+	{
+		bigint_pqt res;
+
+		res.P = p(n1);
+		res.Q = q(n1);
+		res.T = a(n1) * res.P;
+
+		return res;
+	}
+
+	size_t m = n1 + (n2 - n1) / 2;
+
+	return join(split(p, q, a, n1, m), split(p, q, a, m, n2));
+}
+
+bigint_pqt bigint_binary_split(const bigint_term &p, const bigint_term &q, const bigint_term &a, size_t n1, size_t n2,
+                               bigint_executor *ex)
+{
+	if (n2 <= n1)
+		return bigint_pqt{1, 1, 0};
+
+	size_t chunks = (ex != nullptr) ? std::min(n2 - n1, ex->threads() * SPLIT_CHUNKS_PER_THREAD) : 1;
+
+	if (chunks <= 1)
+		return split(p, q, a, n1, n2);
+
+	std::vector<bigint_pqt> parts(chunks);
+
+	ex->run(
+		chunks,
+		[&](size_t i) {
+			parts[i] = split(p, q, a, n1 + (n2 - n1) * i / chunks, n1 + (n2 - n1) * (i + 1) / chunks);
+		},
+		[&](size_t i) { return n1 + (n2 - n1) * (i + 1) / chunks; });
+
+	// Join adjacent pairs level by level, the same tree shape as the recursion
+	while (parts.size() > 1)
+	{
+		std::vector<bigint_pqt> joined((parts.size() + 1) / 2);
+
+		ex->run(
+			joined.size(),
+			[&](size_t i) {
+				if (2 * i + 1 < parts.size())
+					joined[i] = join(parts[2 * i], parts[2 * i + 1]);
+				else
+					joined[i] = std::move(parts[2 * i]);
+			},
+			[&](size_t i) { return parts[2 * i].Q.size(); });
+
+		parts = std::move(joined);
+	}
+
+	return std::move(parts[0]);
+}
+
+static bigint pow10(size_t e)
+{
+	bigint result = 1;
+	bigint base = 10;
+
+	for (; e != 0; e >>= 1)
+	{
+		if (e & 1)
+			result *= base;
+
+		if (e > 1)
+			base *= base;
+	}
+
+	return result;
+}
+
+std::string bigint_fixed_point(const bigint &num, const bigint &den, size_t digits)
+{
+	bigint scaled = (num * pow10(digits)) / den;
+	bool negative = scaled < 0;
+	std::string s = scaled.abs().to_string();
+
+	if (s.size() <= digits)
+		s.insert(0, digits + 1 - s.size(), '0');
+
+	if (digits != 0)
+		s.insert(s.size() - digits, 1, '.');
+
+	return negative ? "-" + s : s;
+}
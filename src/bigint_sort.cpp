@@ -0,0 +1,176 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_sort.hpp"
+
+#include "kernels.hpp"
+#include "magnitude.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#define SORT_SMALL 64       // Buckets sorted by comparisons
+#define SORT_PARALLEL 4096  // Groups split into buckets for the executor
+
+struct sort_group
+{
+	size_t *perm;
+	size_t m;  // Number of keys
+	size_t n;  // Words per key
+	size_t d;  // Next byte, counting from the top
+	bool desc;
+};
+
+static inline unsigned key_byte(const bigint_view &k, size_t n, size_t d, bool desc)
+{
+	unsigned b = (k.data()[n - 1 - d / WORD_SIZE] >> (24 - 8 * (d % WORD_SIZE))) & 0xFF;
+	return desc ? 255 - b : b;
+}
+
+/*
+ * Stable distribution by byte d, repeated on the following bytes while every key
+ * lands in the same bucket. Returns false if all keys are equal.
+ */
+static bool radix_split(const bigint_view *keys, sort_group &g, size_t *tmp, size_t bounds[257])
+{
+	for (; g.d < WORD_SIZE * g.n; ++g.d)
+	{
+		size_t count[256] = {0};
+
+		for (size_t i = 0; i < g.m; ++i)
+			count[key_byte(keys[g.perm[i]], g.n, g.d, g.desc)]++;
+
+		bounds[0] = 0;
+
+		for (int b = 0; b < 256; ++b)
+			bounds[b + 1] = bounds[b] + count[b];
+
+		if (count[key_byte(keys[g.perm[0]], g.n, g.d, g.desc)] == g.m)
+			continue;
+
+		size_t pos[256];
+		memcpy(pos, bounds, sizeof(pos));
+
+		for (size_t i = 0; i < g.m; ++i)
+			tmp[pos[key_byte(keys[g.perm[i]], g.n, g.d, g.desc)]++] = g.perm[i];
+
+		memcpy(g.perm, tmp, g.m * sizeof(size_t));
+		g.d++;
+
+		return true;
+	}
+
+	return false;
+}
+
+static void radix_sort(const bigint_view *keys, sort_group g, size_t *tmp)
+{
+	if (g.m <= SORT_SMALL)
+	{
+		std::stable_sort(g.perm, g.perm + g.m, [&](size_t x, size_t y) {
+			int c = mag_cmp(keys[x].data(), keys[y].data(), g.n);
+			return g.desc ? c > 0 : c < 0;
+		});
+
+		return;
+	}
+
+	size_t bounds[257];
+
+	if (!radix_split(keys, g, tmp, bounds))
+		return;
+
+	for (int b = 0; b < 256; ++b)
+	{
+		sort_group bucket = {g.perm + bounds[b], bounds[b + 1] - bounds[b], g.n, g.d, g.desc};
+
+		if (bucket.m > 1)
+			radix_sort(keys, bucket, tmp + bounds[b]);
+	}
+}
+
+void bigint_sort_order(const bigint_view *keys, size_t n, size_t *perm, bigint_executor *ex)
+{
+	for (size_t i = 0; i < n; ++i)
+		perm[i] = i;
+
+	// Negatives by decreasing word count, zeros, then positives by increasing word count
+	auto rank = [&](size_t i) -> long long {
+		long long wc = keys[i].word_count();
+		return keys[i].is_negative() ? -wc : wc;
+	};
+
+	std::stable_sort(perm, perm + n, [&](size_t x, size_t y) { return rank(x) < rank(y); });
+
+	std::vector<size_t> tmp(n);
+	std::vector<sort_group> groups;
+
+	for (size_t i = 0, j; i < n; i = j)
+	{
+		for (j = i + 1; j < n && rank(perm[j]) == rank(perm[i]); ++j)
+			;
+
+		sort_group g = {perm + i, j - i, keys[perm[i]].word_count(), 0, keys[perm[i]].is_negative()};
+
+		if (g.m < 2 || g.n == 0)
+			continue;
+
+		if (ex == nullptr || g.m <= SORT_PARALLEL)
+		{
+			groups.push_back(g);
+			continue;
+		}
+
+		// Big groups become one task per bucket
+		size_t bounds[257];
+
+		if (!radix_split(keys, g, tmp.data() + i, bounds))
+			continue;
+
+		for (int b = 0; b < 256; ++b)
+		{
+			sort_group bucket = {g.perm + bounds[b], bounds[b + 1] - bounds[b], g.n, g.d, g.desc};
+
+			if (bucket.m > 1)
+				groups.push_back(bucket);
+		}
+	}
+
+	auto sort_one = [&](size_t k) { radix_sort(keys, groups[k], tmp.data() + (groups[k].perm - perm)); };
+
+	if (ex != nullptr)
+	{
+		ex->run(groups.size(), sort_one, [&](size_t k) { return groups[k].m * groups[k].n; });
+	}
+	else
+	{
+		for (size_t k = 0; k < groups.size(); ++k)
+			sort_one(k);
+	}
+}
+
+void bigint_sort(std::vector<bigint> &v, bigint_executor *ex)
+{
+	bigint_sort_by(v.begin(), v.end(), [](const bigint &b) -> const bigint & { return b; }, ex);
+}
@@ -0,0 +1,12 @@
+/*
+ * Algorithm crossover points, in words.
+ * This file is generated by the tune executable (meson compile -C build tune).
+ */
+
+#pragma once
+
+#define MUL_KARATSUBA_THRESHOLD 46
+#define SQR_KARATSUBA_THRESHOLD 81
+#define DIV_BZ_THRESHOLD 102
+#define GET_STR_DC_THRESHOLD 57
+#define SET_STR_DC_THRESHOLD 1879
@@ -0,0 +1,118 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "bigint_tree.hpp"
+
+// fn(i) for i in [0, n), on the executor if there is one
+static void for_each_node(bigint_executor *ex, size_t n, const std::function<void(size_t)> &fn,
+                          const std::function<size_t(size_t)> &cost)
+{
+	if (ex != nullptr)
+	{
+		ex->run(n, fn, cost);
+		return;
+	}
+
+	for (size_t i = 0; i < n; ++i)
+		fn(i);
+}
+
+bigint_product_tree::bigint_product_tree(const std::vector<bigint> &values, bigint_executor *ex)
+	: tree(1, values)
+{
+	for (auto &v : values)
+	{
+		if (v <= 0)
+			throw bigint_exception("values of a product tree must be positive!");
+	}
+
+	if (values.empty())
+		tree[0].push_back(1);
+
+	while (tree.back().size() > 1)
+	{
+		const std::vector<bigint> &below = tree.back();
+		std::vector<bigint> above((below.size() + 1) / 2);
+
+		for_each_node(
+			ex, above.size(),
+			[&](size_t i) {
+				if (2 * i + 1 < below.size())
+					above[i] = below[2 * i] * below[2 * i + 1];
+				else
+					above[i] = below[2 * i];
+			},
+			[&](size_t i) { return below[2 * i].size() + ((2 * i + 1 < below.size()) ? below[2 * i + 1].size() : 0); });
+
+		tree.push_back(std::move(above));
+	}
+}
+
+std::vector<bigint> bigint_product_tree::remainders(const bigint &x, bool squared, bigint_executor *ex) const
+{
+	std::vector<bigint> rems(1, x);
+
+	for (size_t k = tree.size(); k-- > 0;)
+	{
+		const std::vector<bigint> &nodes = tree[k];
+		std::vector<bigint> below(nodes.size());
+
+		for_each_node(
+			ex, nodes.size(),
+			[&](size_t i) {
+				const bigint &parent = rems[i / 2];
+				below[i] = squared ? parent % (nodes[i] * nodes[i]) : parent % nodes[i];
+			},
+			[&](size_t i) { return nodes[i].size(); });
+
+		rems = std::move(below);
+	}
+
+	return rems;
+}
+
+std::vector<bigint> batch_mod(const bigint &x, const std::vector<bigint> &moduli, bigint_executor *ex)
+{
+	if (moduli.empty())
+		return std::vector<bigint>();
+
+	return bigint_product_tree(moduli, ex).remainders(x, false, ex);
+}
+
+/* gcd(v, P / v) = gcd((P mod v^2) / v, v) */
+std::vector<bigint> batch_gcd(const std::vector<bigint> &values, bigint_executor *ex)
+{
+	if (values.empty())
+		return std::vector<bigint>();
+
+	bigint_product_tree tree(values, ex);
+	std::vector<bigint> rems = tree.remainders(tree.product(), true, ex);
+	std::vector<bigint> gcds(values.size());
+
+	for_each_node(
+		ex, values.size(), [&](size_t i) { gcds[i] = (rems[i] / values[i]).gcd(values[i]); },
+		[&](size_t i) { return values[i].size(); });
+
+	return gcds;
+}
@@ -0,0 +1,1047 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "kernels.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+	#define KERNELS_X86_64
+	#include <immintrin.h>
+
+	#define TARGET_BMI2 __attribute__((target("bmi2,adx")))
+	#define TARGET_AVX2 __attribute__((target("avx2,bmi2,adx")))
+	#define TARGET_AVX512 __attribute__((target("avx512f,avx2,bmi2,adx")))
+#endif
+
+/* Generic {{{ */
+
+static word_t add_n_generic(word_t *rp, const word_t *ap, const word_t *bp, size_t n)
+{
+	lword_t carry = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		lword_t sum = static_cast<lword_t>(ap[i]) + bp[i] + carry;
+		rp[i] = sum;
+		carry = sum >> WORD_BITN;
+	}
+
+	return carry;
+}
+
+static word_t sub_n_generic(word_t *rp, const word_t *ap, const word_t *bp, size_t n)
+{
+	lword_t borrow = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		lword_t diff = static_cast<lword_t>(ap[i]) - bp[i] - borrow;
+		rp[i] = diff;
+		borrow = (diff >> WORD_BITN) & 1;
+	}
+
+	return borrow;
+}
+
+static word_t mul_1_generic(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	lword_t carry = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		lword_t prod = static_cast<lword_t>(ap[i]) * b + carry;
+		rp[i] = prod;
+		carry = prod >> WORD_BITN;
+	}
+
+	return carry;
+}
+
+static word_t addmul_1_generic(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	lword_t carry = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		lword_t prod = static_cast<lword_t>(ap[i]) * b + rp[i] + carry;
+		rp[i] = prod;
+		carry = prod >> WORD_BITN;
+	}
+
+	return carry;
+}
+
+static word_t submul_1_generic(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	word_t carry = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		lword_t prod = static_cast<lword_t>(ap[i]) * b + carry;
+		word_t lo = prod;
+		word_t r = rp[i];
+
+		carry = (prod >> WORD_BITN) + (r < lo);
+		rp[i] = r - lo;
+	}
+
+	return carry;
+}
+
+static void mul_basecase_generic(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn)
+{
+	rp[an] = mul_1_generic(rp, ap, an, bp[0]);
+
+	for (size_t i = 1; i < bn; ++i)
+		rp[an + i] = addmul_1_generic(rp + i, ap, an, bp[i]);
+}
+
+static word_t lshift_generic(word_t *rp, const word_t *ap, size_t n, unsigned cnt)
+{
+	unsigned tnc = WORD_BITN - cnt;
+	word_t ret = ap[n - 1] >> tnc;
+
+	for (size_t i = n - 1; i > 0; --i)
+		rp[i] = (ap[i] << cnt) | (ap[i - 1] >> tnc);
+
+	rp[0] = ap[0] << cnt;
+
+	return ret;
+}
+
+static word_t rshift_generic(word_t *rp, const word_t *ap, size_t n, unsigned cnt)
+{
+	unsigned tnc = WORD_BITN - cnt;
+	word_t ret = ap[0] << tnc;
+
+	for (size_t i = 0; i < n - 1; ++i)
+		rp[i] = (ap[i] >> cnt) | (ap[i + 1] << tnc);
+
+	rp[n - 1] = ap[n - 1] >> cnt;
+
+	return ret;
+}
+
+static word_t divrem_1_generic(word_t *qp, const word_t *ap, size_t n, word_t d)
+{
+	lword_t r = 0;
+
+	for (size_t i = n; i-- > 0;)
+	{
+		lword_t u = (r << WORD_BITN) | ap[i];
+		qp[i] = u / d;
+		r = u % d;
+	}
+
+	return r;
+}
+
+static int cmp_n_generic(const word_t *ap, const word_t *bp, size_t n)
+{
+	for (size_t i = n; i-- > 0;)
+	{
+		if (ap[i] != bp[i])
+			return (ap[i] > bp[i]) ? 1 : -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Batch kernels work on the lanes [l0, l1), so the vectorized versions
+ * can use them for the lanes left over.
+ */
+
+#define BATCH_BLOCK 64
+
+static void batch_add_lanes(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n, size_t l0,
+                            size_t l1)
+{
+	for (; l0 < l1; l0 += BATCH_BLOCK)
+	{
+		size_t m = (l1 - l0 < BATCH_BLOCK) ? l1 - l0 : BATCH_BLOCK;
+		word_t carry[BATCH_BLOCK] = {0};
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			size_t o = j * lanes + l0;
+
+			for (size_t l = 0; l < m; ++l)
+			{
+				lword_t sum = static_cast<lword_t>(ap[o + l]) + bp[o + l] + carry[l];
+				rp[o + l] = sum;
+				carry[l] = sum >> WORD_BITN;
+			}
+		}
+	}
+}
+
+static void batch_sub_lanes(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n, size_t l0,
+                            size_t l1)
+{
+	for (; l0 < l1; l0 += BATCH_BLOCK)
+	{
+		size_t m = (l1 - l0 < BATCH_BLOCK) ? l1 - l0 : BATCH_BLOCK;
+		word_t borrow[BATCH_BLOCK] = {0};
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			size_t o = j * lanes + l0;
+
+			for (size_t l = 0; l < m; ++l)
+			{
+				lword_t diff = static_cast<lword_t>(ap[o + l]) - bp[o + l] - borrow[l];
+				rp[o + l] = diff;
+				borrow[l] = (diff >> WORD_BITN) & 1;
+			}
+		}
+	}
+}
+
+static void batch_mul_lanes(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn, size_t lanes,
+                            size_t l0, size_t l1)
+{
+	std::vector<word_t> a(an), b(bn), r(an + bn);
+
+	for (size_t l = l0; l < l1; ++l)
+	{
+		for (size_t j = 0; j < an; ++j)
+			a[j] = ap[j * lanes + l];
+
+		for (size_t j = 0; j < bn; ++j)
+			b[j] = bp[j * lanes + l];
+
+		if (an >= bn)
+			mul_basecase_generic(r.data(), a.data(), an, b.data(), bn);
+		else
+			mul_basecase_generic(r.data(), b.data(), bn, a.data(), an);
+
+		for (size_t j = 0; j < an + bn; ++j)
+			rp[j * lanes + l] = r[j];
+	}
+}
+
+static void batch_cmp_lanes(signed char *cp, const word_t *ap, const word_t *bp, size_t lanes, size_t n, size_t l0,
+                            size_t l1)
+{
+	for (size_t l = l0; l < l1; ++l)
+	{
+		signed char res = 0;
+
+		for (size_t j = n; j-- > 0;)
+		{
+			word_t a = ap[j * lanes + l];
+			word_t b = bp[j * lanes + l];
+
+			if (a != b)
+			{
+				res = (a > b) ? 1 : -1;
+				break;
+			}
+		}
+
+		cp[l] = res;
+	}
+}
+
+static void batch_add_generic(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	batch_add_lanes(rp, ap, bp, lanes, n, 0, lanes);
+}
+
+static void batch_sub_generic(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	batch_sub_lanes(rp, ap, bp, lanes, n, 0, lanes);
+}
+
+static void batch_mul_generic(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn, size_t lanes)
+{
+	batch_mul_lanes(rp, ap, an, bp, bn, lanes, 0, lanes);
+}
+
+static void batch_cmp_generic(signed char *cp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	batch_cmp_lanes(cp, ap, bp, lanes, n, 0, lanes);
+}
+
+static void mulmod_n_generic(word_t *rp, const word_t *ap, const word_t *bp, const word_t *pp, const word_t *mup,
+                             size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		rp[i] = barrett_reduce(static_cast<lword_t>(ap[i]) * bp[i], pp[i], mup[i]);
+}
+
+/* }}} Generic */
+
+#ifdef KERNELS_X86_64
+
+/* BMI2/ADX {{{ */
+
+// These process two words at a time as one 64-bit limb, which is valid
+// since x86-64 is little-endian.
+
+static TARGET_BMI2 word_t add_n_bmi2(word_t *rp, const word_t *ap, const word_t *bp, size_t n)
+{
+	unsigned char carry = 0;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		unsigned long long a, b, r;
+		memcpy(&a, ap + i, 8);
+		memcpy(&b, bp + i, 8);
+		carry = _addcarryx_u64(carry, a, b, &r);
+		memcpy(rp + i, &r, 8);
+	}
+
+	if (i < n)
+	{
+		unsigned int r;
+		carry = _addcarryx_u32(carry, ap[i], bp[i], &r);
+		rp[i] = r;
+	}
+
+	return carry;
+}
+
+static TARGET_BMI2 word_t sub_n_bmi2(word_t *rp, const word_t *ap, const word_t *bp, size_t n)
+{
+	unsigned char borrow = 0;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		unsigned long long a, b, r;
+		memcpy(&a, ap + i, 8);
+		memcpy(&b, bp + i, 8);
+		borrow = _subborrow_u64(borrow, a, b, &r);
+		memcpy(rp + i, &r, 8);
+	}
+
+	if (i < n)
+	{
+		unsigned int r;
+		borrow = _subborrow_u32(borrow, ap[i], bp[i], &r);
+		rp[i] = r;
+	}
+
+	return borrow;
+}
+
+static TARGET_BMI2 word_t mul_1_bmi2(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	unsigned long long carry = 0;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		unsigned long long a, lo, hi;
+		memcpy(&a, ap + i, 8);
+		lo = _mulx_u64(a, b, &hi);
+		lo += carry;
+		hi += (lo < carry);
+		memcpy(rp + i, &lo, 8);
+		carry = hi;
+	}
+
+	if (i < n)
+	{
+		lword_t prod = static_cast<lword_t>(ap[i]) * b + carry;
+		rp[i] = prod;
+		carry = prod >> WORD_BITN;
+	}
+
+	return carry;
+}
+
+static TARGET_BMI2 word_t addmul_1_bmi2(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	unsigned long long carry = 0;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		unsigned long long a, r, lo, hi;
+		memcpy(&a, ap + i, 8);
+		memcpy(&r, rp + i, 8);
+		lo = _mulx_u64(a, b, &hi);
+		lo += carry;
+		hi += (lo < carry);
+		lo += r;
+		hi += (lo < r);
+		memcpy(rp + i, &lo, 8);
+		carry = hi;
+	}
+
+	if (i < n)
+	{
+		lword_t prod = static_cast<lword_t>(ap[i]) * b + rp[i] + carry;
+		rp[i] = prod;
+		carry = prod >> WORD_BITN;
+	}
+
+	return carry;
+}
+
+static TARGET_BMI2 word_t submul_1_bmi2(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	unsigned long long carry = 0;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		unsigned long long a, r, lo, hi;
+		memcpy(&a, ap + i, 8);
+		memcpy(&r, rp + i, 8);
+		lo = _mulx_u64(a, b, &hi);
+		lo += carry;
+		hi += (lo < carry);
+		hi += (r < lo);
+		r -= lo;
+		memcpy(rp + i, &r, 8);
+		carry = hi;
+	}
+
+	if (i < n)
+	{
+		lword_t prod = static_cast<lword_t>(ap[i]) * b + carry;
+		word_t lo = prod;
+		word_t r = rp[i];
+
+		carry = (prod >> WORD_BITN) + (r < lo);
+		rp[i] = r - lo;
+	}
+
+	return carry;
+}
+
+static TARGET_BMI2 void mul_basecase_bmi2(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn)
+{
+	rp[an] = mul_1_bmi2(rp, ap, an, bp[0]);
+
+	for (size_t i = 1; i < bn; ++i)
+		rp[an + i] = addmul_1_bmi2(rp + i, ap, an, bp[i]);
+}
+
+// Division by a single word using a precomputed reciprocal
+// (Möller, Granlund - Improved division by invariant integers),
+// which replaces the hardware division with two multiplications.
+static TARGET_BMI2 word_t divrem_1_bmi2(word_t *qp, const word_t *ap, size_t n, word_t d)
+{
+	unsigned s = CLZ(d);
+	word_t dn = d << s;
+	word_t v = ((static_cast<lword_t>(~dn) << WORD_BITN) | WORD_MAX) / dn;
+	word_t r = 0;
+
+	if (s != 0)
+		r = ap[n - 1] >> (WORD_BITN - s);
+
+	for (size_t i = n; i-- > 0;)
+	{
+		word_t u0 = ap[i] << s;
+		if (s != 0 && i > 0)
+			u0 |= ap[i - 1] >> (WORD_BITN - s);
+
+		lword_t qq = static_cast<lword_t>(v) * r + ((static_cast<lword_t>(r + 1) << WORD_BITN) | u0);
+		word_t q1 = qq >> WORD_BITN;
+		word_t q0 = qq;
+		word_t nr = u0 - q1 * dn;
+
+		if (nr > q0)
+		{
+			q1--;
+			nr += dn;
+		}
+
+		if (nr >= dn)
+		{
+			q1++;
+			nr -= dn;
+		}
+
+		qp[i] = q1;
+		r = nr;
+	}
+
+	return r >> s;
+}
+
+/* }}} BMI2/ADX */
+
+/* AVX2 {{{ */
+
+static TARGET_AVX2 word_t lshift_avx2(word_t *rp, const word_t *ap, size_t n, unsigned cnt)
+{
+	unsigned tnc = WORD_BITN - cnt;
+	word_t ret = ap[n - 1] >> tnc;
+
+	__m128i sl = _mm_cvtsi32_si128(cnt);
+	__m128i sr = _mm_cvtsi32_si128(tnc);
+	size_t i = n - 1;
+
+	// Going from the top, every block reads words that were not written yet
+	for (; i >= 8; i -= 8)
+	{
+		__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i - 7));
+		__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i - 8));
+		__m256i r = _mm256_or_si256(_mm256_sll_epi32(hi, sl), _mm256_srl_epi32(lo, sr));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + i - 7), r);
+	}
+
+	for (; i > 0; --i)
+		rp[i] = (ap[i] << cnt) | (ap[i - 1] >> tnc);
+
+	rp[0] = ap[0] << cnt;
+
+	return ret;
+}
+
+static TARGET_AVX2 word_t rshift_avx2(word_t *rp, const word_t *ap, size_t n, unsigned cnt)
+{
+	unsigned tnc = WORD_BITN - cnt;
+	word_t ret = ap[0] << tnc;
+
+	__m128i sr = _mm_cvtsi32_si128(cnt);
+	__m128i sl = _mm_cvtsi32_si128(tnc);
+	size_t i = 0;
+
+	for (; i + 8 < n; i += 8)
+	{
+		__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i));
+		__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i + 1));
+		__m256i r = _mm256_or_si256(_mm256_srl_epi32(lo, sr), _mm256_sll_epi32(hi, sl));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + i), r);
+	}
+
+	for (; i < n - 1; ++i)
+		rp[i] = (ap[i] >> cnt) | (ap[i + 1] << tnc);
+
+	rp[n - 1] = ap[n - 1] >> cnt;
+
+	return ret;
+}
+
+// Eight words per step, the top differing word is found from the equality mask
+static TARGET_AVX2 int cmp_n_avx2(const word_t *ap, const word_t *bp, size_t n)
+{
+	size_t i = n;
+
+	for (; i >= 8; i -= 8)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i - 8));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + i - 8));
+		unsigned ne = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))) & 0xFF;
+
+		if (ne != 0)
+		{
+			size_t j = i - 8 + (WORD_BITN - 1 - CLZ(ne));
+			return (ap[j] > bp[j]) ? 1 : -1;
+		}
+	}
+
+	return cmp_n_generic(ap, bp, i);
+}
+
+static TARGET_AVX2 void batch_add_avx2(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	const __m256i bias = _mm256_set1_epi32(0x80000000);
+	const __m256i zero = _mm256_setzero_si256();
+	size_t l = 0;
+
+	for (; l + 8 <= lanes; l += 8)
+	{
+		// All ones in lanes with a carry
+		__m256i carry = zero;
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			size_t o = j * lanes + l;
+
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + o));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + o));
+			__m256i s = _mm256_add_epi32(a, b);
+			__m256i c = _mm256_cmpgt_epi32(_mm256_xor_si256(a, bias), _mm256_xor_si256(s, bias));
+			__m256i r = _mm256_sub_epi32(s, carry);
+
+			carry = _mm256_or_si256(c, _mm256_and_si256(carry, _mm256_cmpeq_epi32(r, zero)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + o), r);
+		}
+	}
+
+	batch_add_lanes(rp, ap, bp, lanes, n, l, lanes);
+}
+
+static TARGET_AVX2 void batch_sub_avx2(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	const __m256i bias = _mm256_set1_epi32(0x80000000);
+	const __m256i zero = _mm256_setzero_si256();
+	size_t l = 0;
+
+	for (; l + 8 <= lanes; l += 8)
+	{
+		// All ones in lanes with a borrow
+		__m256i borrow = zero;
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			size_t o = j * lanes + l;
+
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + o));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + o));
+			__m256i d = _mm256_sub_epi32(a, b);
+			__m256i c = _mm256_cmpgt_epi32(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+			__m256i r = _mm256_add_epi32(d, borrow);
+
+			borrow = _mm256_or_si256(c, _mm256_and_si256(borrow, _mm256_cmpeq_epi32(d, zero)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + o), r);
+		}
+	}
+
+	batch_sub_lanes(rp, ap, bp, lanes, n, l, lanes);
+}
+
+/*
+ * Product scanning with four lanes in 64-bit elements. The low and high halves
+ * of the partial products of a column are summed separately, so the sums
+ * can't overflow.
+ */
+static TARGET_AVX2 void batch_mul_avx2(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn,
+                                       size_t lanes)
+{
+	const __m256i mask = _mm256_set1_epi64x(WORD_MAX);
+	const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	size_t l = 0;
+
+	for (; l + 4 <= lanes; l += 4)
+	{
+		__m256i carry = _mm256_setzero_si256();
+
+		for (size_t k = 0; k < an + bn - 1; ++k)
+		{
+			__m256i lo = carry;
+			__m256i hi = _mm256_setzero_si256();
+
+			size_t i0 = (k >= bn) ? k - bn + 1 : 0;
+			size_t i1 = (k < an) ? k : an - 1;
+
+			for (size_t i = i0; i <= i1; ++i)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ap + i * lanes + l));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bp + (k - i) * lanes + l));
+				__m256i p = _mm256_mul_epu32(_mm256_cvtepu32_epi64(a), _mm256_cvtepu32_epi64(b));
+
+				lo = _mm256_add_epi64(lo, _mm256_and_si256(p, mask));
+				hi = _mm256_add_epi64(hi, _mm256_srli_epi64(p, WORD_BITN));
+			}
+
+			__m256i r = _mm256_permutevar8x32_epi32(lo, even);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(rp + k * lanes + l), _mm256_castsi256_si128(r));
+
+			carry = _mm256_add_epi64(_mm256_srli_epi64(lo, WORD_BITN), hi);
+		}
+
+		__m256i r = _mm256_permutevar8x32_epi32(carry, even);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(rp + (an + bn - 1) * lanes + l), _mm256_castsi256_si128(r));
+	}
+
+	batch_mul_lanes(rp, ap, an, bp, bn, lanes, l, lanes);
+}
+
+static TARGET_AVX2 void batch_cmp_avx2(signed char *cp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	const __m256i bias = _mm256_set1_epi32(0x80000000);
+	const __m256i one = _mm256_set1_epi32(1);
+	size_t l = 0;
+
+	for (; l + 8 <= lanes; l += 8)
+	{
+		__m256i res = _mm256_setzero_si256();
+		__m256i undecided = _mm256_set1_epi32(-1);
+
+		for (size_t j = n; j-- > 0;)
+		{
+			size_t o = j * lanes + l;
+
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + o));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + o));
+			__m256i ab = _mm256_xor_si256(a, bias);
+			__m256i bb = _mm256_xor_si256(b, bias);
+
+			__m256i gt = _mm256_and_si256(_mm256_cmpgt_epi32(ab, bb), one);
+			__m256i lt = _mm256_cmpgt_epi32(bb, ab);
+
+			res = _mm256_or_si256(res, _mm256_and_si256(undecided, _mm256_or_si256(gt, lt)));
+			undecided = _mm256_and_si256(undecided, _mm256_cmpeq_epi32(a, b));
+
+			if (_mm256_testz_si256(undecided, undecided))
+				break;
+		}
+
+		int32_t out[8];
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), res);
+
+		for (int i = 0; i < 8; ++i)
+			cp[l + i] = out[i];
+	}
+
+	batch_cmp_lanes(cp, ap, bp, lanes, n, l, lanes);
+}
+
+// Barrett reduction in four 64-bit lanes, the remainders are below 2^33 so the signed compares are fine
+static TARGET_AVX2 void mulmod_n_avx2(word_t *rp, const word_t *ap, const word_t *bp, const word_t *pp,
+                                      const word_t *mup, size_t n)
+{
+	const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i a = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ap + i)));
+		__m256i b = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bp + i)));
+		__m256i p = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pp + i)));
+		__m256i mu = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(mup + i)));
+
+		__m256i x = _mm256_mul_epu32(a, b);
+		__m256i q = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 30), mu), 32);
+		__m256i r = _mm256_sub_epi64(x, _mm256_mul_epu32(q, p));
+
+		r = _mm256_sub_epi64(r, _mm256_andnot_si256(_mm256_cmpgt_epi64(p, r), p));
+		r = _mm256_sub_epi64(r, _mm256_andnot_si256(_mm256_cmpgt_epi64(p, r), p));
+
+		r = _mm256_permutevar8x32_epi32(r, even);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(rp + i), _mm256_castsi256_si128(r));
+	}
+
+	mulmod_n_generic(rp + i, ap + i, bp + i, pp + i, mup + i, n - i);
+}
+
+/* }}} AVX2 */
+
+/* AVX-512 {{{ */
+
+static TARGET_AVX512 int cmp_n_avx512(const word_t *ap, const word_t *bp, size_t n)
+{
+	size_t i = n;
+
+	for (; i >= 16; i -= 16)
+	{
+		__m512i a = _mm512_loadu_si512(ap + i - 16);
+		__m512i b = _mm512_loadu_si512(bp + i - 16);
+		unsigned ne = _mm512_cmpneq_epi32_mask(a, b);
+
+		if (ne != 0)
+		{
+			size_t j = i - 16 + (WORD_BITN - 1 - CLZ(ne));
+			return (ap[j] > bp[j]) ? 1 : -1;
+		}
+	}
+
+	return cmp_n_avx2(ap, bp, i);
+}
+
+static TARGET_AVX512 void batch_add_avx512(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	const __m512i one = _mm512_set1_epi32(1);
+	size_t l = 0;
+
+	for (; l + 16 <= lanes; l += 16)
+	{
+		__mmask16 carry = 0;
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			size_t o = j * lanes + l;
+
+			__m512i a = _mm512_loadu_si512(ap + o);
+			__m512i b = _mm512_loadu_si512(bp + o);
+			__m512i s = _mm512_add_epi32(a, b);
+			__mmask16 c = _mm512_cmplt_epu32_mask(s, a);
+			__m512i r = _mm512_mask_add_epi32(s, carry, s, one);
+
+			carry = c | (carry & _mm512_cmpeq_epi32_mask(r, _mm512_setzero_si512()));
+			_mm512_storeu_si512(rp + o, r);
+		}
+	}
+
+	batch_add_lanes(rp, ap, bp, lanes, n, l, lanes);
+}
+
+static TARGET_AVX512 void batch_sub_avx512(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n)
+{
+	const __m512i one = _mm512_set1_epi32(1);
+	size_t l = 0;
+
+	for (; l + 16 <= lanes; l += 16)
+	{
+		__mmask16 borrow = 0;
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			size_t o = j * lanes + l;
+
+			__m512i a = _mm512_loadu_si512(ap + o);
+			__m512i b = _mm512_loadu_si512(bp + o);
+			__m512i d = _mm512_sub_epi32(a, b);
+			__mmask16 c = _mm512_cmplt_epu32_mask(a, b);
+			__m512i r = _mm512_mask_sub_epi32(d, borrow, d, one);
+
+			borrow = c | (borrow & _mm512_cmpeq_epi32_mask(d, _mm512_setzero_si512()));
+			_mm512_storeu_si512(rp + o, r);
+		}
+	}
+
+	batch_sub_lanes(rp, ap, bp, lanes, n, l, lanes);
+}
+
+// The batch kernels use the maskz_ forms with full masks, GCC warns about the undefined source of the plain ones
+static TARGET_AVX512 void batch_mul_avx512(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn,
+                                           size_t lanes)
+{
+	const __m512i mask = _mm512_set1_epi64(WORD_MAX);
+	size_t l = 0;
+
+	for (; l + 8 <= lanes; l += 8)
+	{
+		__m512i carry = _mm512_setzero_si512();
+
+		for (size_t k = 0; k < an + bn - 1; ++k)
+		{
+			__m512i lo = carry;
+			__m512i hi = _mm512_setzero_si512();
+
+			size_t i0 = (k >= bn) ? k - bn + 1 : 0;
+			size_t i1 = (k < an) ? k : an - 1;
+
+			for (size_t i = i0; i <= i1; ++i)
+			{
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i * lanes + l));
+				__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + (k - i) * lanes + l));
+				__m512i p = _mm512_maskz_mul_epu32(0xFF, _mm512_maskz_cvtepu32_epi64(0xFF, a),
+				                                   _mm512_maskz_cvtepu32_epi64(0xFF, b));
+
+				lo = _mm512_add_epi64(lo, _mm512_and_si512(p, mask));
+				hi = _mm512_add_epi64(hi, _mm512_maskz_srli_epi64(0xFF, p, WORD_BITN));
+			}
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + k * lanes + l), _mm512_maskz_cvtepi64_epi32(0xFF, lo));
+			carry = _mm512_add_epi64(_mm512_maskz_srli_epi64(0xFF, lo, WORD_BITN), hi);
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + (an + bn - 1) * lanes + l),
+		                    _mm512_maskz_cvtepi64_epi32(0xFF, carry));
+	}
+
+	batch_mul_lanes(rp, ap, an, bp, bn, lanes, l, lanes);
+}
+
+static TARGET_AVX512 void batch_cmp_avx512(signed char *cp, const word_t *ap, const word_t *bp, size_t lanes,
+                                           size_t n)
+{
+	const __m512i one = _mm512_set1_epi32(1);
+	const __m512i minus_one = _mm512_set1_epi32(-1);
+	size_t l = 0;
+
+	for (; l + 16 <= lanes; l += 16)
+	{
+		__m512i res = _mm512_setzero_si512();
+		__mmask16 undecided = 0xFFFF;
+
+		for (size_t j = n; j-- > 0 && undecided != 0;)
+		{
+			size_t o = j * lanes + l;
+
+			__m512i a = _mm512_loadu_si512(ap + o);
+			__m512i b = _mm512_loadu_si512(bp + o);
+
+			res = _mm512_mask_mov_epi32(res, undecided & _mm512_cmpgt_epu32_mask(a, b), one);
+			res = _mm512_mask_mov_epi32(res, undecided & _mm512_cmplt_epu32_mask(a, b), minus_one);
+			undecided &= _mm512_cmpeq_epi32_mask(a, b);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(cp + l), _mm512_maskz_cvtepi32_epi8(0xFFFF, res));
+	}
+
+	batch_cmp_lanes(cp, ap, bp, lanes, n, l, lanes);
+}
+
+static TARGET_AVX512 void mulmod_n_avx512(word_t *rp, const word_t *ap, const word_t *bp, const word_t *pp,
+                                          const word_t *mup, size_t n)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512i a = _mm512_maskz_cvtepu32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ap + i)));
+		__m512i b = _mm512_maskz_cvtepu32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + i)));
+		__m512i p = _mm512_maskz_cvtepu32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pp + i)));
+		__m512i mu = _mm512_maskz_cvtepu32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mup + i)));
+
+		__m512i x = _mm512_maskz_mul_epu32(0xFF, a, b);
+		__m512i q = _mm512_maskz_mul_epu32(0xFF, _mm512_maskz_srli_epi64(0xFF, x, 30), mu);
+		__m512i r = _mm512_sub_epi64(x, _mm512_maskz_mul_epu32(0xFF, _mm512_maskz_srli_epi64(0xFF, q, 32), p));
+
+		r = _mm512_mask_sub_epi64(r, _mm512_cmpge_epu64_mask(r, p), r, p);
+		r = _mm512_mask_sub_epi64(r, _mm512_cmpge_epu64_mask(r, p), r, p);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(rp + i), _mm512_maskz_cvtepi64_epi32(0xFF, r));
+	}
+
+	mulmod_n_generic(rp + i, ap + i, bp + i, pp + i, mup + i, n - i);
+}
+
+/* }}} AVX-512 */
+
+#endif
+
+/* Dispatch {{{ */
+
+static const bigint_kernels generic_kernels = {
+	"generic",
+	add_n_generic,
+	sub_n_generic,
+	mul_1_generic,
+	addmul_1_generic,
+	submul_1_generic,
+	mul_basecase_generic,
+	lshift_generic,
+	rshift_generic,
+	divrem_1_generic,
+	cmp_n_generic,
+	batch_add_generic,
+	batch_sub_generic,
+	batch_mul_generic,
+	batch_cmp_generic,
+	mulmod_n_generic,
+};
+
+#ifdef KERNELS_X86_64
+
+static const bigint_kernels bmi2_kernels = {
+	"bmi2",
+	add_n_bmi2,
+	sub_n_bmi2,
+	mul_1_bmi2,
+	addmul_1_bmi2,
+	submul_1_bmi2,
+	mul_basecase_bmi2,
+	lshift_generic,
+	rshift_generic,
+	divrem_1_bmi2,
+	cmp_n_generic,
+	batch_add_generic,
+	batch_sub_generic,
+	batch_mul_generic,
+	batch_cmp_generic,
+	mulmod_n_generic,
+};
+
+static const bigint_kernels avx2_kernels = {
+	"avx2",
+	add_n_bmi2,
+	sub_n_bmi2,
+	mul_1_bmi2,
+	addmul_1_bmi2,
+	submul_1_bmi2,
+	mul_basecase_bmi2,
+	lshift_avx2,
+	rshift_avx2,
+	divrem_1_bmi2,
+	cmp_n_avx2,
+	batch_add_avx2,
+	batch_sub_avx2,
+	batch_mul_avx2,
+	batch_cmp_avx2,
+	mulmod_n_avx2,
+};
+
+static const bigint_kernels avx512_kernels = {
+	"avx512",
+	add_n_bmi2,
+	sub_n_bmi2,
+	mul_1_bmi2,
+	addmul_1_bmi2,
+	submul_1_bmi2,
+	mul_basecase_bmi2,
+	lshift_avx2,
+	rshift_avx2,
+	divrem_1_bmi2,
+	cmp_n_avx512,
+	batch_add_avx512,
+	batch_sub_avx512,
+	batch_mul_avx512,
+	batch_cmp_avx512,
+	mulmod_n_avx512,
+};
+
+#endif
+
+// Points to the generic set until the initializer below runs, so bigints
+// constructed during static initialization of other units are still fine.
+const bigint_kernels *kernels = &generic_kernels;
+
+static const bigint_kernels *select_kernels()
+{
+	const bigint_kernels *best = &generic_kernels;
+	const bigint_kernels *supported[4] = {&generic_kernels, nullptr, nullptr, nullptr};
+
+#ifdef KERNELS_X86_64
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx"))
+	{
+		best = supported[1] = &bmi2_kernels;
+
+		if (__builtin_cpu_supports("avx2"))
+		{
+			best = supported[2] = &avx2_kernels;
+
+			if (__builtin_cpu_supports("avx512f"))
+				best = supported[3] = &avx512_kernels;
+		}
+	}
+#endif
+
+	// Unknown or unsupported sets are ignored
+	const char *env = getenv("BIGINT_KERNELS");
+
+	if (env != nullptr)
+	{
+		for (auto set : supported)
+		{
+			if (set != nullptr && strcmp(set->name, env) == 0)
+				return set;
+		}
+	}
+
+	return best;
+}
+
+static struct kernels_init
+{
+	kernels_init() { kernels = select_kernels(); }
+} kernels_init_instance;
+
+/* }}} Dispatch */
@@ -0,0 +1,152 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+	#include <intrin.h>
+#endif
+
+typedef uint32_t word_t;
+typedef uint64_t lword_t;
+typedef int64_t slword_t;
+
+#define WORD_BITN 32
+#define WORD_MAX UINT32_MAX
+#define WORD_MASK WORD_MAX
+#define WORD_BASE (1ULL << WORD_BITN)
+#define WORD_SIZE 4
+
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	#define HOST_LITTLE_ENDIAN
+#endif
+
+#ifdef _WIN32
+	#define CLZ(x) __lzcnt(x)
+	#define CTZ(x) _tzcnt_u32(x)
+#else
+	#define CLZ(x) __builtin_clz(x)
+	#define CTZ(x) __builtin_ctz(x)
+#endif
+
+/*
+ * Low-level kernels working on little-endian arrays of words.
+ *
+ * Every kernel exists in a portable version and, where the compiler allows it,
+ * in versions built for specific instruction set extensions. The best set for
+ * the running CPU is picked once at load time; the BIGINT_KERNELS environment
+ * variable can force a particular set ("generic", "bmi2", "avx2", "avx512").
+ *
+ * Unless stated otherwise rp may be equal to ap (or bp), but must not
+ * partially overlap them.
+ */
+struct bigint_kernels
+{
+	const char *name;
+
+	/* rp = ap + bp, returns carry */
+	word_t (*add_n)(word_t *rp, const word_t *ap, const word_t *bp, size_t n);
+	/* rp = ap - bp, returns borrow */
+	word_t (*sub_n)(word_t *rp, const word_t *ap, const word_t *bp, size_t n);
+	/* rp = ap * b, returns high word */
+	word_t (*mul_1)(word_t *rp, const word_t *ap, size_t n, word_t b);
+	/* rp += ap * b, returns high word */
+	word_t (*addmul_1)(word_t *rp, const word_t *ap, size_t n, word_t b);
+	/* rp -= ap * b, returns high word to be subtracted */
+	word_t (*submul_1)(word_t *rp, const word_t *ap, size_t n, word_t b);
+	/* rp[0..an+bn) = ap * bp, an >= bn > 0, rp must not overlap inputs */
+	void (*mul_basecase)(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn);
+	/* rp = ap << cnt, 0 < cnt < WORD_BITN, rp >= ap, returns bits shifted out */
+	word_t (*lshift)(word_t *rp, const word_t *ap, size_t n, unsigned cnt);
+	/* rp = ap >> cnt, 0 < cnt < WORD_BITN, rp <= ap, returns bits shifted out
+	 * in the high end of the word */
+	word_t (*rshift)(word_t *rp, const word_t *ap, size_t n, unsigned cnt);
+	/* qp = ap / d, returns remainder, d != 0 */
+	word_t (*divrem_1)(word_t *qp, const word_t *ap, size_t n, word_t d);
+	/* -1, 0 or 1 as ap compares to bp, scanning from the top word */
+	int (*cmp_n)(const word_t *ap, const word_t *bp, size_t n);
+
+	/*
+	 * Batches of numbers in structure-of-arrays layout, word j of lane l is at
+	 * [j * lanes + l]. They are vectorized across lanes.
+	 */
+
+	/* rp = ap + bp mod 2^(n * WORD_BITN) in every lane */
+	void (*batch_add)(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n);
+	/* rp = ap - bp mod 2^(n * WORD_BITN) in every lane */
+	void (*batch_sub)(word_t *rp, const word_t *ap, const word_t *bp, size_t lanes, size_t n);
+	/* rp[0..an+bn) = ap * bp in every lane, rp must not overlap inputs */
+	void (*batch_mul)(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn, size_t lanes);
+	/* cp[l] = -1, 0 or 1 as ap compares to bp in lane l */
+	void (*batch_cmp)(signed char *cp, const word_t *ap, const word_t *bp, size_t lanes, size_t n);
+
+	/*
+	 * rp[i] = ap[i] * bp[i] mod pp[i] by Barrett reduction, 2^30 < pp[i] < 2^31,
+	 * ap[i], bp[i] < pp[i] and mup[i] = floor(2^62 / pp[i])
+	 */
+	void (*mulmod_n)(word_t *rp, const word_t *ap, const word_t *bp, const word_t *pp, const word_t *mup, size_t n);
+};
+
+extern const bigint_kernels *kernels;
+
+static inline word_t add_1(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		word_t a = ap[i];
+		rp[i] = a + b;
+		b = (rp[i] < a);
+	}
+
+	return b;
+}
+
+/* x mod p, x < 2^62, 2^30 < p < 2^31 and mu = floor(2^62 / p), the estimated quotient is short by at most 2 */
+static inline word_t barrett_reduce(lword_t x, word_t p, word_t mu)
+{
+	lword_t q = ((x >> 30) * mu) >> 32;
+	lword_t r = x - q * p;
+
+	if (r >= p)
+		r -= p;
+
+	if (r >= p)
+		r -= p;
+
+	return r;
+}
+
+static inline word_t sub_1(word_t *rp, const word_t *ap, size_t n, word_t b)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		word_t a = ap[i];
+		rp[i] = a - b;
+		b = (a < b);
+	}
+
+	return b;
+}
@@ -0,0 +1,897 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "magnitude.hpp"
+
+#include "bigint_thresholds.hpp"
+#include "stats.hpp"
+
+#include <algorithm>
+
+bigint_thresholds thresholds = {
+	MUL_KARATSUBA_THRESHOLD,
+	SQR_KARATSUBA_THRESHOLD,
+	DIV_BZ_THRESHOLD,
+	GET_STR_DC_THRESHOLD,
+	SET_STR_DC_THRESHOLD,
+};
+
+/* Multiplication {{{ */
+
+static void sqr_basecase(word_t *rp, const word_t *ap, size_t n)
+{
+	if (n == 1)
+	{
+		lword_t p = static_cast<lword_t>(ap[0]) * ap[0];
+		rp[0] = p;
+		rp[1] = p >> WORD_BITN;
+		return;
+	}
+
+	// Products a[i] * a[j] for i < j, each computed once
+	rp[0] = 0;
+	rp[n] = kernels->mul_1(rp + 1, ap + 1, n - 1, ap[0]);
+
+	for (size_t i = 1; i < n - 1; ++i)
+		rp[n + i] = kernels->addmul_1(rp + 2 * i + 1, ap + i + 1, n - i - 1, ap[i]);
+
+	rp[2 * n - 1] = 0;
+	kernels->lshift(rp, rp, 2 * n, 1);
+
+	// Plus the squares on the diagonal
+	lword_t carry = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		lword_t p = static_cast<lword_t>(ap[i]) * ap[i];
+		lword_t s = static_cast<lword_t>(rp[2 * i]) + static_cast<word_t>(p) + carry;
+
+		rp[2 * i] = s;
+		s = static_cast<lword_t>(rp[2 * i + 1]) + (p >> WORD_BITN) + (s >> WORD_BITN);
+		rp[2 * i + 1] = s;
+		carry = s >> WORD_BITN;
+	}
+}
+
+// Adds z1 (the middle Karatsuba term) to rp, where rp has n words.
+static void add_middle(word_t *rp, size_t n, const word_t *z1, size_t z1n)
+{
+	z1n = mag_normalized_size(z1, z1n);
+
+	word_t carry = kernels->add_n(rp, rp, z1, z1n);
+	add_1(rp + z1n, rp + z1n, n - z1n, carry);
+}
+
+// Karatsuba, h < bn <= an: a = a1 * B^h + a0, b = b1 * B^h + b0,
+// a * b = z2 * B^2h + ((a0 + a1)(b0 + b1) - z2 - z0) * B^h + z0
+static void mul_karatsuba(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn)
+{
+	size_t h = (an + 1) / 2;
+	size_t n1 = an - h;
+	size_t m1 = bn - h;
+
+	std::vector<word_t> sa(h + 1), sb(h + 1), z1(2 * h + 2);
+
+	word_t carry = kernels->add_n(sa.data(), ap, ap + h, n1);
+	sa[h] = add_1(sa.data() + n1, ap + n1, h - n1, carry);
+
+	carry = kernels->add_n(sb.data(), bp, bp + h, m1);
+	sb[h] = add_1(sb.data() + m1, bp + m1, h - m1, carry);
+
+	mag_mul(rp, ap, h, bp, h);
+	mag_mul(rp + 2 * h, ap + h, n1, bp + h, m1);
+	mag_mul(z1.data(), sa.data(), h + 1, sb.data(), h + 1);
+
+	word_t borrow = kernels->sub_n(z1.data(), z1.data(), rp, 2 * h);
+	sub_1(z1.data() + 2 * h, z1.data() + 2 * h, 2, borrow);
+
+	borrow = kernels->sub_n(z1.data(), z1.data(), rp + 2 * h, n1 + m1);
+	sub_1(z1.data() + n1 + m1, z1.data() + n1 + m1, 2 * h + 2 - n1 - m1, borrow);
+
+	add_middle(rp + h, an + bn - h, z1.data(), z1.size());
+}
+
+// Splits a into pieces of bn words, bn <= (an + 1) / 2
+static void mul_unbalanced(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn)
+{
+	std::vector<word_t> tmp(2 * bn);
+
+	mag_mul(rp, ap, bn, bp, bn);
+
+	for (size_t i = bn; i < an; i += bn)
+	{
+		size_t cn = std::min(bn, an - i);
+
+		if (cn == bn)
+			mag_mul(tmp.data(), ap + i, bn, bp, bn);
+		else
+			mag_mul(tmp.data(), bp, bn, ap + i, cn);
+
+		// rp[i..i+bn) holds the high part of the previous piece
+		word_t carry = kernels->add_n(rp + i, rp + i, tmp.data(), bn);
+		add_1(rp + i + bn, tmp.data() + bn, cn, carry);
+	}
+}
+
+static void sqr_karatsuba(word_t *rp, const word_t *ap, size_t n)
+{
+	size_t h = (n + 1) / 2;
+	size_t n1 = n - h;
+
+	std::vector<word_t> sa(h + 1), z1(2 * h + 2);
+
+	word_t carry = kernels->add_n(sa.data(), ap, ap + h, n1);
+	sa[h] = add_1(sa.data() + n1, ap + n1, h - n1, carry);
+
+	mag_sqr(rp, ap, h);
+	mag_sqr(rp + 2 * h, ap + h, n1);
+	mag_sqr(z1.data(), sa.data(), h + 1);
+
+	word_t borrow = kernels->sub_n(z1.data(), z1.data(), rp, 2 * h);
+	sub_1(z1.data() + 2 * h, z1.data() + 2 * h, 2, borrow);
+
+	borrow = kernels->sub_n(z1.data(), z1.data(), rp + 2 * h, 2 * n1);
+	sub_1(z1.data() + 2 * n1, z1.data() + 2 * n1, 2 * h + 2 - 2 * n1, borrow);
+
+	add_middle(rp + h, 2 * n - h, z1.data(), z1.size());
+}
+
+void mag_mul(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn)
+{
+	if (ap == bp && an == bn)
+	{
+		mag_sqr(rp, ap, an);
+	}
+	else if (bn < thresholds.mul_karatsuba)
+	{
+		STATS_TIER(TIER_MUL_BASECASE);
+		kernels->mul_basecase(rp, ap, an, bp, bn);
+	}
+	else if (bn <= (an + 1) / 2)
+	{
+		STATS_TIER(TIER_MUL_UNBALANCED);
+		mul_unbalanced(rp, ap, an, bp, bn);
+	}
+	else
+	{
+		STATS_TIER(TIER_MUL_KARATSUBA);
+		mul_karatsuba(rp, ap, an, bp, bn);
+	}
+}
+
+void mag_sqr(word_t *rp, const word_t *ap, size_t n)
+{
+	if (n < thresholds.sqr_karatsuba)
+	{
+		STATS_TIER(TIER_SQR_BASECASE);
+		sqr_basecase(rp, ap, n);
+	}
+	else
+	{
+		STATS_TIER(TIER_SQR_KARATSUBA);
+		sqr_karatsuba(rp, ap, n);
+	}
+}
+
+/* }}} Multiplication */
+
+/* Division {{{ */
+
+// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D.
+// vp is normalized (high bit set), vn >= 2 and the top vn words of up are
+// less than vp. Stores un - vn quotient words to qp and leaves
+// the remainder in up[0..vn).
+static void div_knuth(word_t *qp, word_t *up, size_t un, const word_t *vp, size_t vn)
+{
+	word_t v1 = vp[vn - 1];
+	word_t v2 = vp[vn - 2];
+
+	for (size_t j = un - vn; j-- > 0;)
+	{
+		// Compute estimate qhat of q[j]
+		lword_t num = (static_cast<lword_t>(up[j + vn]) << WORD_BITN) | up[j + vn - 1];
+		lword_t qhat = num / v1;
+		lword_t rhat = num % v1;
+
+		while (qhat >= WORD_BASE || qhat * v2 > ((rhat << WORD_BITN) | up[j + vn - 2]))
+		{
+			qhat -= 1;
+			rhat += v1;
+
+			if (rhat >= WORD_BASE)
+				break;
+		}
+
+		// Multiply and subtract
+		word_t borrow = kernels->submul_1(up + j, vp, vn, qhat);
+		word_t top = up[j + vn];
+		up[j + vn] = top - borrow;
+
+		if (top < borrow)  // If we subtracted too much, add back
+		{
+			qhat -= 1;
+			up[j + vn] += kernels->add_n(up + j, up + j, vp, vn);
+		}
+
+		qp[j] = qhat;
+	}
+}
+
+static void div_2n_by_n(word_t *qp, word_t *ap, const word_t *dp, size_t n);
+
+// Burnikel, Ziegler - Fast Recursive Division, algorithm 2.
+// Divides ap[0..3h) < dp * B^h by the normalized dp[0..2h),
+// leaving the remainder in ap[0..2h).
+static void div_3h_by_2h(word_t *qp, word_t *ap, const word_t *dp, size_t h)
+{
+	const word_t *d0 = dp;
+	const word_t *d1 = dp + h;
+
+	if (mag_cmp(ap + 2 * h, d1, h) < 0)
+	{
+		div_2n_by_n(qp, ap + h, d1, h);
+	}
+	else
+	{
+		// qhat = B^h - 1, r1 = a2a1 - qhat * d1 = (a2 - d1) * B^h + a1 + d1
+		std::fill(qp, qp + h, WORD_MAX);
+		kernels->sub_n(ap + 2 * h, ap + 2 * h, d1, h);
+		word_t carry = kernels->add_n(ap + h, ap + h, d1, h);
+		add_1(ap + 2 * h, ap + 2 * h, h, carry);
+	}
+
+	std::vector<word_t> dq(2 * h);
+	mag_mul(dq.data(), qp, h, d0, h);
+
+	word_t borrow = kernels->sub_n(ap, ap, dq.data(), 2 * h);
+	borrow = sub_1(ap + 2 * h, ap + 2 * h, h, borrow);
+
+	// Happens at most twice
+	while (borrow != 0)
+	{
+		sub_1(qp, qp, h, 1);
+
+		word_t carry = kernels->add_n(ap, ap, dp, 2 * h);
+		if (add_1(ap + 2 * h, ap + 2 * h, h, carry) != 0)
+			borrow = 0;
+	}
+}
+
+// Divides ap[0..2n), whose top half is less than the normalized dp[0..n),
+// leaving the remainder in ap[0..n).
+static void div_2n_by_n(word_t *qp, word_t *ap, const word_t *dp, size_t n)
+{
+	if (n % 2 != 0 || n < thresholds.div_bz)
+	{
+		div_knuth(qp, ap, 2 * n, dp, n);
+		return;
+	}
+
+	size_t h = n / 2;
+
+	div_3h_by_2h(qp + h, ap + h, dp, h);
+	div_3h_by_2h(qp, ap, dp, h);
+}
+
+static void divrem_knuth(word_t *qp, word_t *rp, const word_t *up, size_t un, const word_t *vp, size_t vn)
+{
+	// Normalize by shifting v left just enough so that
+	// its high-order bit is on, and shift u left the
+	// same amount. We may have to append a high-order
+	// digit on the dividend; we do that unconditionally.
+
+	std::vector<word_t> u(un + 1), v(vn);
+	unsigned s = CLZ(vp[vn - 1]);
+
+	if (s != 0)
+	{
+		kernels->lshift(v.data(), vp, vn, s);
+		u[un] = kernels->lshift(u.data(), up, un, s);
+	}
+	else
+	{
+		std::copy(vp, vp + vn, v.begin());
+		std::copy(up, up + un, u.begin());
+	}
+
+	div_knuth(qp, u.data(), un + 1, v.data(), vn);
+
+	// Unnormalize the remainder
+	if (s != 0)
+		kernels->rshift(rp, u.data(), vn, s);
+	else
+		std::copy(u.begin(), u.begin() + vn, rp);
+}
+
+static void divrem_bz(word_t *qp, word_t *rp, const word_t *up, size_t un, const word_t *vp, size_t vn)
+{
+	// Pad the divisor to n = j * 2^k words, so that the recursion
+	// halves it k times before reaching a block smaller than the threshold.
+	size_t m = 1;
+
+	while (vn / m >= thresholds.div_bz)
+		m *= 2;
+
+	size_t n = (vn + m - 1) / m * m;
+	size_t w = n - vn;
+	unsigned s = CLZ(vp[vn - 1]);
+
+	// The shifted dividend has len words and is split into t blocks of n words,
+	// the top one partially filled with r words. There is a spare zero word on top.
+	size_t len = un + w + 1;
+	size_t t = (len + n - 1) / n;
+	size_t r = len - (t - 1) * n;
+
+	std::vector<word_t> v(n, 0), u(t * n + 1, 0);
+	std::vector<word_t> q(std::max((t - 2) * n + r + 1, un - vn + 1), 0);
+
+	if (s != 0)
+	{
+		kernels->lshift(v.data() + w, vp, vn, s);
+		u[un + w] = kernels->lshift(u.data() + w, up, un, s);
+	}
+	else
+	{
+		std::copy(vp, vp + vn, v.begin() + w);
+		std::copy(up, up + un, u.begin() + w);
+	}
+
+	// The top block only yields r + 1 quotient words, so it is cheaper
+	// to divide it by the schoolbook method. Then every step divides
+	// the previous remainder followed by the next block, in place.
+	div_knuth(q.data() + (t - 2) * n, u.data() + (t - 2) * n, n + r + 1, v.data(), n);
+
+	for (size_t i = t - 2; i-- > 0;)
+		div_2n_by_n(q.data() + i * n, u.data() + i * n, v.data(), n);
+
+	std::copy(q.begin(), q.begin() + (un - vn + 1), qp);
+
+	if (s != 0)
+		kernels->rshift(rp, u.data() + w, vn, s);
+	else
+		std::copy(u.begin() + w, u.begin() + n, rp);
+}
+
+void mag_divrem(word_t *qp, word_t *rp, const word_t *up, size_t un, const word_t *vp, size_t vn)
+{
+	if (vn == 1)
+	{
+		STATS_TIER(TIER_DIV_1);
+		rp[0] = kernels->divrem_1(qp, up, un, vp[0]);
+	}
+	else if (vn >= thresholds.div_bz && un - vn >= thresholds.div_bz)
+	{
+		STATS_TIER(TIER_DIV_BZ);
+		divrem_bz(qp, rp, up, un, vp, vn);
+	}
+	else
+	{
+		STATS_TIER(TIER_DIV_KNUTH);
+		divrem_knuth(qp, rp, up, un, vp, vn);
+	}
+}
+
+/* }}} Division */
+
+/* Exact division {{{ */
+
+static size_t trailing_zeros(const word_t *ap)
+{
+	size_t i = 0;
+
+	while (ap[i] == 0)
+		++i;
+
+	return i * WORD_BITN + CTZ(ap[i]);
+}
+
+// rp[0..n - s/WORD_BITN) = ap >> s
+static size_t shift_right(word_t *rp, const word_t *ap, size_t n, size_t s)
+{
+	size_t w = s / WORD_BITN;
+	unsigned cnt = s % WORD_BITN;
+
+	if (cnt != 0)
+		kernels->rshift(rp, ap + w, n - w, cnt);
+	else
+		std::copy(ap + w, ap + n, rp);
+
+	return mag_normalized_size(rp, n - w);
+}
+
+/*
+ * Hensel division of rp[0..rn) by an odd dp: every step picks the quotient word
+ * that clears the lowest remaining word of rp, so that rp - q * dp ends up with
+ * qn zero low words. The borrow of a step is only carried one word up, into
+ * the next step. Words of q * dp above rn are dropped, returns whether any
+ * of them was nonzero.
+ */
+static bool bdiv(word_t *qp, word_t *rp, size_t rn, const word_t *dp, size_t dn, size_t qn)
+{
+	word_t inv = binvert_word(dp[0]);
+	lword_t pending = 0;  // To be subtracted at rp[i + dn]
+	bool out = false;
+
+	for (size_t i = 0; i < qn; ++i)
+	{
+		word_t q = rp[i] * inv;
+		size_t m = std::min(dn, rn - i);
+		lword_t t = kernels->submul_1(rp + i, dp, m, q) + pending;
+
+		if (i + m < rn)
+		{
+			word_t w = rp[i + m];
+			rp[i + m] = w - static_cast<word_t>(t);
+			pending = (t >> WORD_BITN) + (w < static_cast<word_t>(t));
+		}
+		else
+		{
+			out |= (t != 0);
+			pending = 0;
+		}
+
+		if (qp)
+			qp[i] = q;
+	}
+
+	return out || pending != 0;
+}
+
+void mag_divexact(word_t *qp, const word_t *ap, size_t an, const word_t *dp, size_t dn)
+{
+	size_t qn = an - dn + 1;
+
+	if (dn >= thresholds.div_bz && qn >= thresholds.div_bz)
+	{
+		std::vector<word_t> r(dn);
+		mag_divrem(qp, r.data(), ap, an, dp, dn);
+		return;
+	}
+
+	std::fill(qp, qp + qn, 0);
+
+	// The quotient doesn't change when 2^s is removed from both
+	size_t s = trailing_zeros(dp);
+	std::vector<word_t> a(an), d(dn);
+
+	an = shift_right(a.data(), ap, an, s);
+	dn = shift_right(d.data(), dp, dn, s);
+
+	if (an < dn)
+		return;
+
+	// The quotient still fits in qn words, and only the low qn words of the remainder matter
+	qn = std::min(qn, an - dn + 1);
+	bdiv(qp, a.data(), qn, d.data(), dn, qn);
+}
+
+/*
+ * With qn = an - dn + 1 quotient words, a - q * d = R * b^qn where -d < R < d,
+ * so d divides a exactly when the whole remainder is zero.
+ */
+bool mag_divisible(const word_t *ap, size_t an, const word_t *dp, size_t dn)
+{
+	an = mag_normalized_size(ap, an);
+
+	if (ap[an - 1] == 0)
+		return true;
+
+	size_t s = trailing_zeros(dp);
+
+	if (trailing_zeros(ap) < s)
+		return false;
+
+	if (dn == 1 && s == 0)
+	{
+		lword_t r = 0;
+
+		for (size_t i = an; i-- > 0;)
+			r = ((r << WORD_BITN) | ap[i]) % dp[0];
+
+		return r == 0;
+	}
+
+	std::vector<word_t> a(an), d(dn);
+
+	an = shift_right(a.data(), ap, an, s);
+	dn = shift_right(d.data(), dp, dn, s);
+
+	if (an < dn)
+		return false;
+
+	if (bdiv(nullptr, a.data(), an, d.data(), dn, an - dn + 1))
+		return false;
+
+	return mag_normalized_size(a.data(), an) == 1 && a[0] == 0;
+}
+
+/* }}} Exact division */
+
+/* Radix conversion {{{ */
+
+static const char digit_chars[] = "0123456789ABCDEF";
+
+struct radix
+{
+	int base;
+	word_t big_base;  // The largest power of base fitting in a word
+	unsigned digits;  // Digits in big_base
+};
+
+/* Digits are collected in buf and handed to the sink, if any, in chunks */
+struct str_out
+{
+	std::string buf;
+	const mag_str_sink *sink;
+
+	void flush_if_full()
+	{
+		if (sink && buf.size() >= 65536)
+			flush();
+	}
+
+	void flush()
+	{
+		if (!buf.empty())
+			(*sink)(&buf[0], buf.size());
+
+		buf.clear();
+	}
+};
+
+static radix radix_info(int base)
+{
+	radix r = {base, static_cast<word_t>(base), 1};
+
+	while (static_cast<lword_t>(r.big_base) * base <= WORD_MAX)
+	{
+		r.big_base *= base;
+		r.digits++;
+	}
+
+	return r;
+}
+
+static unsigned pow2_bits(int base)
+{
+	return (base & (base - 1)) == 0 ? CTZ(base) : 0;
+}
+
+// pows[i] = big_base^(2^i), as long as it has at most max_words words
+static std::vector<std::vector<word_t>> radix_powers(const radix &r, size_t max_words)
+{
+	std::vector<std::vector<word_t>> pows(1, std::vector<word_t>(1, r.big_base));
+
+	while (2 * pows.back().size() <= max_words)
+	{
+		const std::vector<word_t> &p = pows.back();
+		std::vector<word_t> sq(2 * p.size());
+
+		mag_sqr(sq.data(), p.data(), p.size());
+		sq.resize(mag_normalized_size(sq.data(), sq.size()));
+		pows.push_back(sq);
+	}
+
+	return pows;
+}
+
+static void get_str_pow2(str_out &out, const word_t *ap, size_t n, unsigned bits)
+{
+	size_t ndigits = (mag_bit_length(ap, n) + bits - 1) / bits;
+	word_t mask = (1U << bits) - 1;
+
+	for (size_t d = ndigits; d-- > 0;)
+	{
+		size_t pos = d * bits;
+		size_t wi = pos / WORD_BITN;
+		unsigned bi = pos % WORD_BITN;
+
+		word_t v = ap[wi] >> bi;
+		if (bi + bits > WORD_BITN && wi + 1 < n)
+			v |= ap[wi + 1] << (WORD_BITN - bi);
+
+		out.buf.push_back(digit_chars[v & mask]);
+
+		if ((d & 0xFFF) == 0)
+			out.flush_if_full();
+	}
+}
+
+// Appends the digits of ap, left-padded with zeros to pad digits
+static void get_str_basecase(str_out &out, const word_t *ap, size_t n, const radix &r, size_t pad)
+{
+	std::vector<word_t> x(ap, ap + n);
+	std::string rev;
+
+	n = mag_normalized_size(x.data(), n);
+
+	while (n > 1 || x[0] != 0)
+	{
+		word_t rem = kernels->divrem_1(x.data(), x.data(), n, r.big_base);
+		n = mag_normalized_size(x.data(), n);
+
+		for (unsigned k = 0; k < r.digits; ++k)
+		{
+			rev.push_back(digit_chars[rem % r.base]);
+			rem /= r.base;
+		}
+	}
+
+	while (!rev.empty() && rev.back() == '0')
+		rev.pop_back();
+
+	if (pad > rev.size())
+		rev.append(pad - rev.size(), '0');
+
+	out.buf.append(rev.rbegin(), rev.rend());
+	out.flush_if_full();
+}
+
+// Splits the number by the largest power that is about half of it
+static void get_str_dc(str_out &out, const word_t *ap, size_t n, const radix &r, size_t pad,
+                       const std::vector<std::vector<word_t>> &pows)
+{
+	n = mag_normalized_size(ap, n);
+
+	size_t i = pows.size();
+
+	while (i > 0 && 2 * pows[i - 1].size() > n + 1)
+		--i;
+
+	if (n < thresholds.get_str_dc || i == 0)
+	{
+		get_str_basecase(out, ap, n, r, pad);
+		return;
+	}
+
+	const std::vector<word_t> &p = pows[i - 1];
+	size_t lo_digits = static_cast<size_t>(r.digits) << (i - 1);
+
+	std::vector<word_t> q(n - p.size() + 1), rem(p.size());
+	mag_divrem(q.data(), rem.data(), ap, n, p.data(), p.size());
+
+	get_str_dc(out, q.data(), q.size(), r, pad > lo_digits ? pad - lo_digits : 0, pows);
+	std::vector<word_t>().swap(q);
+	get_str_dc(out, rem.data(), rem.size(), r, lo_digits, pows);
+}
+
+static void write_str(str_out &out, const word_t *ap, size_t n, int base)
+{
+	n = mag_normalized_size(ap, n);
+
+	if (n == 1 && ap[0] == 0)
+	{
+		out.buf.push_back('0');
+		return;
+	}
+
+	unsigned bits = pow2_bits(base);
+
+	if (bits != 0)
+	{
+		STATS_TIER(TIER_RADIX_POW2);
+		get_str_pow2(out, ap, n, bits);
+		return;
+	}
+
+	radix r = radix_info(base);
+
+	if (n < thresholds.get_str_dc)
+	{
+		STATS_TIER(TIER_GET_STR_BASECASE);
+		get_str_basecase(out, ap, n, r, 0);
+	}
+	else
+	{
+		STATS_TIER(TIER_GET_STR_DC);
+		get_str_dc(out, ap, n, r, 0, radix_powers(r, (n + 1) / 2));
+	}
+}
+
+std::string mag_get_str(const word_t *ap, size_t n, int base)
+{
+	str_out out = {std::string(), nullptr};
+	write_str(out, ap, n, base);
+
+	return std::move(out.buf);
+}
+
+void mag_write_str(const word_t *ap, size_t n, int base, const mag_str_sink &sink)
+{
+	str_out out = {std::string(), &sink};
+	write_str(out, ap, n, base);
+	out.flush();
+}
+
+// Chunks of width bits each, most significant first, then tail_len * bits more bits in tail
+static std::vector<word_t> set_chunks_pow2(const word_t *chunks, size_t n, word_t tail, unsigned tail_bits,
+                                           unsigned width)
+{
+	std::vector<word_t> x((n * width + tail_bits + WORD_BITN - 1) / WORD_BITN + 1, 0);
+
+	x[0] = tail;
+
+	for (size_t d = 0; d < n; ++d)
+	{
+		size_t pos = tail_bits + d * width;
+		size_t wi = pos / WORD_BITN;
+		unsigned bi = pos % WORD_BITN;
+		word_t v = chunks[n - 1 - d];
+
+		x[wi] |= v << bi;
+		if (bi + width > WORD_BITN)
+			x[wi + 1] |= v >> (WORD_BITN - bi);
+	}
+
+	x.resize(mag_normalized_size(x.data(), x.size()));
+	return x;
+}
+
+static std::vector<word_t> set_chunks_basecase(const word_t *chunks, size_t n, const radix &r)
+{
+	std::vector<word_t> x(1, 0);
+	x.reserve(n + 1);
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		word_t chunk = chunks[i];
+		word_t carry = kernels->mul_1(x.data(), x.data(), x.size(), r.big_base);
+
+		for (size_t j = 0; chunk != 0 && j < x.size(); ++j)
+		{
+			x[j] += chunk;
+			chunk = (x[j] < chunk);
+		}
+
+		carry += chunk;
+
+		if (carry != 0)
+			x.push_back(carry);
+	}
+
+	return x;
+}
+
+static std::vector<word_t> set_chunks_dc(const word_t *chunks, size_t n, const radix &r, size_t bits,
+                                         const std::vector<std::vector<word_t>> &pows)
+{
+	size_t i = pows.size();
+
+	while (i > 0 && (static_cast<size_t>(1) << (i - 1)) >= n)
+		--i;
+
+	if (n * r.digits * bits / WORD_BITN < thresholds.set_str_dc || i == 0)
+		return set_chunks_basecase(chunks, n, r);
+
+	const std::vector<word_t> &p = pows[i - 1];
+	size_t lo_n = static_cast<size_t>(1) << (i - 1);
+	size_t hi_n = n - lo_n;
+
+	std::vector<word_t> hi = set_chunks_dc(chunks, hi_n, r, bits, pows);
+	std::vector<word_t> lo = set_chunks_dc(chunks + hi_n, lo_n, r, bits, pows);
+	std::vector<word_t> x(hi.size() + p.size());
+
+	if (hi.size() >= p.size())
+		mag_mul(x.data(), hi.data(), hi.size(), p.data(), p.size());
+	else
+		mag_mul(x.data(), p.data(), p.size(), hi.data(), hi.size());
+
+	word_t carry = kernels->add_n(x.data(), x.data(), lo.data(), lo.size());
+	add_1(x.data() + lo.size(), x.data() + lo.size(), x.size() - lo.size(), carry);
+
+	x.resize(mag_normalized_size(x.data(), x.size()));
+	return x;
+}
+
+unsigned mag_chunk_digits(int base)
+{
+	return radix_info(base).digits;
+}
+
+std::vector<word_t> mag_set_chunks(const word_t *chunks, size_t n, word_t tail, unsigned tail_len, int base)
+{
+	while (n > 0 && chunks[0] == 0)
+	{
+		chunks++;
+		n--;
+	}
+
+	radix r = radix_info(base);
+	unsigned bits = pow2_bits(base);
+
+	if (bits != 0)
+	{
+		STATS_TIER(TIER_RADIX_POW2);
+		return set_chunks_pow2(chunks, n, tail, tail_len * bits, r.digits * bits);
+	}
+
+	// Upper bound of bits per digit, only used to estimate the size
+	bits = 32 - CLZ(base);
+
+	std::vector<word_t> x;
+
+	if (n * r.digits * bits / WORD_BITN < thresholds.set_str_dc)
+	{
+		STATS_TIER(TIER_SET_STR_BASECASE);
+		x = set_chunks_basecase(chunks, n, r);
+	}
+	else
+	{
+		STATS_TIER(TIER_SET_STR_DC);
+		std::vector<std::vector<word_t>> pows(1, std::vector<word_t>(1, r.big_base));
+
+		while ((static_cast<size_t>(1) << pows.size()) < n)
+		{
+			const std::vector<word_t> &p = pows.back();
+			std::vector<word_t> sq(2 * p.size());
+
+			mag_sqr(sq.data(), p.data(), p.size());
+			sq.resize(mag_normalized_size(sq.data(), sq.size()));
+			pows.push_back(sq);
+		}
+
+		x = set_chunks_dc(chunks, n, r, bits, pows);
+	}
+
+	// x * base^tail_len + tail
+	word_t scale = 1;
+
+	for (unsigned i = 0; i < tail_len; ++i)
+		scale *= base;
+
+	word_t carry = kernels->mul_1(x.data(), x.data(), x.size(), scale);
+	carry += add_1(x.data(), x.data(), x.size(), tail);
+
+	if (carry != 0)
+		x.push_back(carry);
+
+	return x;
+}
+
+std::vector<word_t> mag_set_str(const unsigned char *digits, size_t len, int base)
+{
+	unsigned k = mag_chunk_digits(base);
+	std::vector<word_t> chunks;
+	chunks.reserve(len / k);
+
+	size_t i = 0;
+
+	for (; i + k <= len; i += k)
+	{
+		word_t chunk = 0;
+
+		for (unsigned j = 0; j < k; ++j)
+			chunk = chunk * base + digits[i + j];
+
+		chunks.push_back(chunk);
+	}
+
+	word_t tail = 0;
+
+	for (size_t j = i; j < len; ++j)
+		tail = tail * base + digits[j];
+
+	return mag_set_chunks(chunks.data(), chunks.size(), tail, len - i, base);
+}
+
+/* }}} Radix conversion */
@@ -0,0 +1,132 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "bigint.hpp"
+#include "kernels.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Algorithms on magnitudes, i.e. unsigned little-endian arrays of words.
+ * These pick between the schoolbook and the subquadratic algorithms
+ * using the thresholds below.
+ */
+
+extern bigint_thresholds thresholds;
+
+/* rp[0..an+bn) = ap * bp, an >= bn > 0, rp must not overlap inputs */
+void mag_mul(word_t *rp, const word_t *ap, size_t an, const word_t *bp, size_t bn);
+
+/* rp[0..2n) = ap^2, rp must not overlap ap */
+void mag_sqr(word_t *rp, const word_t *ap, size_t n);
+
+/*
+ * qp[0..un-vn] = up / vp, rp[0..vn) = up % vp,
+ * un >= vn > 0, vp[vn - 1] != 0, qp and rp must not overlap inputs
+ */
+void mag_divrem(word_t *qp, word_t *rp, const word_t *up, size_t un, const word_t *vp, size_t vn);
+
+/*
+ * qp[0..an-dn] = ap / dp when dp divides ap, by Hensel (2-adic) division,
+ * an >= dn > 0, dp[dn - 1] != 0, qp must not overlap inputs
+ */
+void mag_divexact(word_t *qp, const word_t *ap, size_t an, const word_t *dp, size_t dn);
+
+/* Whether dp divides ap, without computing the quotient, an > 0, dn > 0, dp[dn - 1] != 0 */
+bool mag_divisible(const word_t *ap, size_t an, const word_t *dp, size_t dn);
+
+/* Digits of ap in base [2, 16] without leading zeros, "0" for zero */
+std::string mag_get_str(const word_t *ap, size_t n, int base);
+
+/* Same digits, passed to sink in order in chunks of bounded size; the sink may modify them */
+typedef std::function<void(char *, size_t)> mag_str_sink;
+void mag_write_str(const word_t *ap, size_t n, int base, const mag_str_sink &sink);
+
+/* Magnitude from len digit values (most significant first) in base [2, 16] */
+std::vector<word_t> mag_set_str(const unsigned char *digits, size_t len, int base);
+
+/*
+ * Same from digits packed as they are read: n chunks of mag_chunk_digits(base) digits each,
+ * most significant first, then tail_len fewer digits in tail. A chunk holds its digits as a number.
+ */
+unsigned mag_chunk_digits(int base);
+std::vector<word_t> mag_set_chunks(const word_t *chunks, size_t n, word_t tail, unsigned tail_len, int base);
+
+/* dst = src, without a copy unless dst uses another allocator */
+static inline void mag_assign(std::vector<word_t> &dst, std::vector<word_t> &&src)
+{
+	dst = std::move(src);
+}
+
+template <class Alloc>
+static inline void mag_assign(std::vector<word_t, Alloc> &dst, std::vector<word_t> &&src)
+{
+	dst.assign(src.begin(), src.end());
+}
+
+static inline size_t mag_normalized_size(const word_t *ap, size_t n)
+{
+	while (n > 1 && ap[n - 1] == 0)
+		--n;
+
+	return n;
+}
+
+/* n is 0 for a moved-from bigint */
+static inline bool mag_is_zero(const word_t *ap, size_t n)
+{
+	return n == 0 || (n == 1 && ap[0] == 0);
+}
+
+/* Number of significant bits, ap must be normalized, n may be 0 */
+static inline size_t mag_bit_length(const word_t *ap, size_t n)
+{
+	if (n == 0 || ap[n - 1] == 0)
+		return 0;
+
+	return (n - 1) * WORD_BITN + (WORD_BITN - CLZ(ap[n - 1]));
+}
+
+// Inverse of an odd d modulo 2^WORD_BITN, every Newton step doubles the correct bits
+static inline word_t binvert_word(word_t d)
+{
+	word_t x = d;  // d * d = 1 mod 8
+
+	for (int i = 0; i < 4; ++i)
+		x *= 2 - d * x;
+
+	return x;
+}
+
+static inline int mag_cmp(const word_t *ap, const word_t *bp, size_t n)
+{
+	// Most comparisons are decided by the top word
+	if (n != 0 && ap[n - 1] != bp[n - 1])
+		return (ap[n - 1] > bp[n - 1]) ? 1 : -1;
+
+	return kernels->cmp_n(ap, bp, n);
+}
@@ -0,0 +1,264 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "montgomery.hpp"
+
+#include "magnitude.hpp"
+
+#include <algorithm>
+
+// Words of x, zero padded to k
+static void load_words(word_t *rp, const bigint &x, size_t k)
+{
+	bigint_view v(x);
+
+	std::fill(rp, rp + k, 0);
+	std::copy(v.data(), v.data() + v.word_count(), rp);
+}
+
+// Rows of kernel calls, for any size
+static void mul_cios(const mont_ctx &m, word_t *rp, const word_t *ap, const word_t *bp, word_t *tp)
+{
+	size_t k = m.k;
+	const word_t *np = m.n.data();
+
+	std::fill(tp, tp + 2 * k + 1, 0);
+
+	// Step i adds a * b[i] and the multiple of n clearing tp[i]; tp[i + k + 1] is still zero
+	for (size_t i = 0; i < k; ++i)
+	{
+		word_t *t = tp + i;
+
+		lword_t s = static_cast<lword_t>(t[k]) + kernels->addmul_1(t, ap, k, bp[i]);
+		t[k] = s;
+		word_t hi = s >> WORD_BITN;
+
+		s = static_cast<lword_t>(t[k]) + kernels->addmul_1(t, np, k, t[0] * m.ninv);
+		t[k] = s;
+		t[k + 1] = hi + static_cast<word_t>(s >> WORD_BITN);
+	}
+
+	// The result is below 2n
+	word_t *res = tp + k;
+
+	if (res[k] != 0 || mag_cmp(res, np, k) >= 0)
+		kernels->sub_n(rp, res, np, k);
+	else
+		std::copy(res, res + k, rp);
+}
+
+#ifdef __SIZEOF_INT128__
+
+typedef unsigned __int128 dlword_t;
+
+// Both products of a step in one pass over a window on the stack, on double words
+template <size_t K>
+static void mul_cios_fixed(const mont_ctx &m, word_t *rp, const word_t *ap, const word_t *bp, word_t *)
+{
+	const size_t D = K / 2;
+
+	const lword_t *n = m.n2.data();
+	const lword_t ninv = m.ninv2;
+	lword_t a[D], b[D], t[D + 2] = {0};
+
+	for (size_t j = 0; j < D; ++j)
+	{
+		a[j] = ap[2 * j] | static_cast<lword_t>(ap[2 * j + 1]) << WORD_BITN;
+		b[j] = bp[2 * j] | static_cast<lword_t>(bp[2 * j + 1]) << WORD_BITN;
+	}
+
+	for (size_t i = 0; i < D; ++i)
+	{
+		dlword_t s;
+		lword_t c = 0;
+
+		for (size_t j = 0; j < D; ++j)
+		{
+			s = static_cast<dlword_t>(a[j]) * b[i] + t[j] + c;
+			t[j] = s;
+			c = s >> 64;
+		}
+
+		s = static_cast<dlword_t>(t[D]) + c;
+		t[D] = s;
+		t[D + 1] = s >> 64;
+
+		// Adding q * n clears the low double word, the window moves down by one
+		lword_t q = t[0] * ninv;
+
+		s = static_cast<dlword_t>(q) * n[0] + t[0];
+		c = s >> 64;
+
+		for (size_t j = 1; j < D; ++j)
+		{
+			s = static_cast<dlword_t>(q) * n[j] + t[j] + c;
+			t[j - 1] = s;
+			c = s >> 64;
+		}
+
+		s = static_cast<dlword_t>(t[D]) + c;
+		t[D - 1] = s;
+		t[D] = t[D + 1] + static_cast<lword_t>(s >> 64);
+	}
+
+	word_t res[K];
+
+	for (size_t j = 0; j < D; ++j)
+	{
+		res[2 * j] = t[j];
+		res[2 * j + 1] = t[j] >> WORD_BITN;
+	}
+
+	if (t[D] != 0 || mag_cmp(res, m.n.data(), K) >= 0)
+		kernels->sub_n(rp, res, m.n.data(), K);
+	else
+		std::copy(res, res + K, rp);
+}
+
+#endif
+
+mont_ctx::mont_ctx(const bigint &modulus)
+{
+	bigint_view v(modulus);
+
+	if (v.is_negative() || v.word_count() == 0 || (v.data()[0] & 1) == 0 || modulus == 1)
+		throw bigint_exception("modulus must be odd and greater than one!");
+
+	k = v.word_count();
+	n.assign(v.data(), v.data() + k);
+	ninv = -binvert_word(n[0]);
+	ninv2 = 0;
+	mul_fn = mul_cios;
+
+#ifdef __SIZEOF_INT128__
+	switch (k)
+	{
+	case 8:
+		mul_fn = mul_cios_fixed<8>;
+		break;
+	case 12:
+		mul_fn = mul_cios_fixed<12>;
+		break;
+	case 16:
+		mul_fn = mul_cios_fixed<16>;
+		break;
+	case 64:
+		mul_fn = mul_cios_fixed<64>;
+		break;
+	case 128:
+		mul_fn = mul_cios_fixed<128>;
+		break;
+	}
+
+	if (mul_fn != mul_cios)
+	{
+		n2.resize(k / 2);
+
+		for (size_t j = 0; j < k / 2; ++j)
+			n2[j] = n[2 * j] | static_cast<lword_t>(n[2 * j + 1]) << WORD_BITN;
+
+		// -n^-1 mod 2^64 by one more Newton step
+		lword_t inv = binvert_word(n[0]);
+		inv *= 2 - n2[0] * inv;
+		ninv2 = -inv;
+	}
+#endif
+
+	r2.resize(k);
+	one.resize(k);
+
+	bigint r = bigint(1).mul_2exp(k * WORD_BITN) % modulus;
+	load_words(one.data(), r, k);
+	load_words(r2.data(), r * r % modulus, k);
+}
+
+void mont_ctx::add(word_t *rp, const word_t *ap, const word_t *bp) const
+{
+	word_t carry = kernels->add_n(rp, ap, bp, k);
+
+	if (carry != 0 || mag_cmp(rp, n.data(), k) >= 0)
+		kernels->sub_n(rp, rp, n.data(), k);
+}
+
+void mont_ctx::sub(word_t *rp, const word_t *ap, const word_t *bp) const
+{
+	if (kernels->sub_n(rp, ap, bp, k) != 0)
+		kernels->add_n(rp, rp, n.data(), k);
+}
+
+void mont_ctx::neg(word_t *rp, const word_t *ap) const
+{
+	if (is_zero(ap))
+		std::fill(rp, rp + k, 0);
+	else
+		kernels->sub_n(rp, n.data(), ap, k);
+}
+
+void mont_ctx::pow(word_t *rp, const word_t *ap, const word_t *ep, size_t en, word_t *tp) const
+{
+	std::vector<word_t> base(ap, ap + k);
+
+	std::copy(one.begin(), one.end(), rp);
+
+	while (en > 0 && ep[en - 1] == 0)
+		en--;
+
+	if (en == 0)
+		return;
+
+	// The top bit only copies the base
+	size_t i = en * WORD_BITN - CLZ(ep[en - 1]) - 1;
+	std::copy(base.begin(), base.end(), rp);
+
+	while (i-- > 0)
+	{
+		mul(rp, rp, rp, tp);
+
+		if ((ep[i / WORD_BITN] >> (i % WORD_BITN)) & 1)
+			mul(rp, rp, base.data(), tp);
+	}
+}
+
+void mont_ctx::to_mont(word_t *rp, const bigint &x, word_t *tp) const
+{
+	std::vector<word_t> w(k);
+
+	load_words(w.data(), x, k);
+	mul(rp, w.data(), r2.data(), tp);
+}
+
+bigint mont_ctx::from_mont(const word_t *ap, word_t *tp) const
+{
+	std::vector<word_t> w(k), unit(k, 0);
+
+	unit[0] = 1;
+	mul(w.data(), ap, unit.data(), tp);
+
+	return bigint(bigint_view(w.data(), k, 0));
+}
+
+bool mont_ctx::is_zero(const word_t *ap) const
+{
+	return std::all_of(ap, ap + k, [](word_t w) { return w == 0; });
+}
@@ -0,0 +1,71 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint.hpp"
+#include "kernels.hpp"
+
+#include <vector>
+
+/*
+ * Montgomery arithmetic modulo an odd n > 1 of k words, R = 2^(k * WORD_BITN).
+ * Numbers are k-word arrays below n owned by the caller, so that loops
+ * can work on preallocated buffers. Multiplication needs a scratch buffer
+ * of scratch_size() words; results may alias the operands.
+ */
+struct mont_ctx
+{
+	size_t k;
+	std::vector<word_t> n;
+	std::vector<word_t> r2;   // R^2 mod n
+	std::vector<word_t> one;  // R mod n, i.e. 1 in Montgomery form
+	word_t ninv;              // -n^-1 mod 2^WORD_BITN
+
+	/* For the unrolled sizes: n as 64-bit double words and -n^-1 mod 2^64 */
+	std::vector<lword_t> n2;
+	lword_t ninv2;
+
+	/* Unrolled for 256, 384, 512, 2048 and 4096-bit moduli, otherwise on the kernels */
+	void (*mul_fn)(const mont_ctx &, word_t *, const word_t *, const word_t *, word_t *);
+
+	explicit mont_ctx(const bigint &modulus);  // throw
+
+	size_t scratch_size() const { return 2 * k + 1; }
+
+	/* rp = ap * bp / R mod n, coarsely integrated operand scanning */
+	void mul(word_t *rp, const word_t *ap, const word_t *bp, word_t *tp) const { mul_fn(*this, rp, ap, bp, tp); }
+	void add(word_t *rp, const word_t *ap, const word_t *bp) const;
+	void sub(word_t *rp, const word_t *ap, const word_t *bp) const;
+	void neg(word_t *rp, const word_t *ap) const;
+
+	/* rp = ap^e in Montgomery form, e as words */
+	void pow(word_t *rp, const word_t *ap, const word_t *ep, size_t en, word_t *tp) const;
+
+	/* Conversion of values below n */
+	void to_mont(word_t *rp, const bigint &x, word_t *tp) const;
+	bigint from_mont(const word_t *ap, word_t *tp) const;
+
+	bool is_zero(const word_t *ap) const;
+};
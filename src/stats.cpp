@@ -0,0 +1,202 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "stats.hpp"
+
+#include <cstring>
+
+#ifdef BIGINT_STATS
+
+	#include <atomic>
+	#include <chrono>
+
+static std::atomic<uint64_t> op_calls[bigint_stats::OP_COUNT];
+static std::atomic<uint64_t> op_sizes[bigint_stats::OP_COUNT][bigint_stats::SIZE_BUCKETS];
+static std::atomic<uint64_t> tier_calls[bigint_stats::TIER_COUNT];
+static std::atomic<uint64_t> tier_ns[bigint_stats::TIER_COUNT];
+static std::atomic<uint64_t> clamp_erased;
+static std::atomic<uint64_t> allocations;
+static std::atomic<uint64_t> allocated_bytes;
+static std::atomic<uint64_t> deallocations;
+
+static thread_local int tier_depth = 0;
+
+static uint64_t now_ns()
+{
+	auto t = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count();
+}
+
+void stats_op(int op, size_t n)
+{
+	int bucket = 0;
+
+	while (n > 1 && bucket < bigint_stats::SIZE_BUCKETS - 1)
+	{
+		n >>= 1;
+		bucket++;
+	}
+
+	op_calls[op].fetch_add(1, std::memory_order_relaxed);
+	op_sizes[op][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void stats_clamp(size_t erased)
+{
+	if (erased != 0)
+		clamp_erased.fetch_add(erased, std::memory_order_relaxed);
+}
+
+stats_tier_scope::stats_tier_scope(int tier)
+	: tier(tier)
+	, outermost(tier_depth++ == 0)
+	, start(outermost ? now_ns() : 0)
+{}
+
+stats_tier_scope::~stats_tier_scope()
+{
+	tier_depth--;
+
+	if (outermost)
+	{
+		tier_calls[tier].fetch_add(1, std::memory_order_relaxed);
+		tier_ns[tier].fetch_add(now_ns() - start, std::memory_order_relaxed);
+	}
+}
+
+bool bigint_stats::enabled()
+{
+	return true;
+}
+
+bigint_stats bigint_stats::snapshot()
+{
+	bigint_stats s;
+
+	for (int i = 0; i < OP_COUNT; ++i)
+	{
+		s.calls[i] = op_calls[i].load(std::memory_order_relaxed);
+
+		for (int j = 0; j < SIZE_BUCKETS; ++j)
+			s.sizes[i][j] = op_sizes[i][j].load(std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < TIER_COUNT; ++i)
+	{
+		s.tier_calls[i] = ::tier_calls[i].load(std::memory_order_relaxed);
+		s.tier_ns[i] = ::tier_ns[i].load(std::memory_order_relaxed);
+	}
+
+	s.clamp_erased = ::clamp_erased.load(std::memory_order_relaxed);
+	s.allocations = ::allocations.load(std::memory_order_relaxed);
+	s.allocated_bytes = ::allocated_bytes.load(std::memory_order_relaxed);
+	s.deallocations = ::deallocations.load(std::memory_order_relaxed);
+
+	return s;
+}
+
+void bigint_stats::reset()
+{
+	for (int i = 0; i < OP_COUNT; ++i)
+	{
+		op_calls[i].store(0, std::memory_order_relaxed);
+
+		for (int j = 0; j < SIZE_BUCKETS; ++j)
+			op_sizes[i][j].store(0, std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < TIER_COUNT; ++i)
+	{
+		::tier_calls[i].store(0, std::memory_order_relaxed);
+		::tier_ns[i].store(0, std::memory_order_relaxed);
+	}
+
+	::clamp_erased.store(0, std::memory_order_relaxed);
+	::allocations.store(0, std::memory_order_relaxed);
+	::allocated_bytes.store(0, std::memory_order_relaxed);
+	::deallocations.store(0, std::memory_order_relaxed);
+}
+
+void bigint_stats::record_alloc(size_t bytes)
+{
+	::allocations.fetch_add(1, std::memory_order_relaxed);
+	::allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void bigint_stats::record_free(size_t)
+{
+	::deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+#else
+
+bool bigint_stats::enabled()
+{
+	return false;
+}
+
+bigint_stats bigint_stats::snapshot()
+{
+	bigint_stats s;
+	memset(&s, 0, sizeof(s));
+	return s;
+}
+
+void bigint_stats::reset() {}
+
+void bigint_stats::record_alloc(size_t) {}
+
+void bigint_stats::record_free(size_t) {}
+
+#endif
+
+const char *bigint_stats::op_name(int op)
+{
+	static const char *names[OP_COUNT] = {
+		"add", "sub", "mul", "div", "shift", "bitwise", "cmp", "conv_int", "conv_string", "to_string",
+	};
+
+	return (op >= 0 && op < OP_COUNT) ? names[op] : "unknown";
+}
+
+const char *bigint_stats::tier_name(int tier)
+{
+	static const char *names[TIER_COUNT] = {
+		"mul_basecase",
+		"mul_karatsuba",
+		"mul_unbalanced",
+		"sqr_basecase",
+		"sqr_karatsuba",
+		"div_1",
+		"div_knuth",
+		"div_bz",
+		"radix_pow2",
+		"get_str_basecase",
+		"get_str_dc",
+		"set_str_basecase",
+		"set_str_dc",
+	};
+
+	return (tier >= 0 && tier < TIER_COUNT) ? names[tier] : "unknown";
+}
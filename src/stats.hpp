@@ -0,0 +1,63 @@
+/*
+ * bigint.cpp - Arbitrary-Precision Integer Arithmetic Library
+ * Copyright © 2021 infastin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "bigint_stats.hpp"
+
+#include <cstddef>
+
+/*
+ * Recording side of bigint_stats.
+ * Without BIGINT_STATS the macros expand to nothing.
+ */
+
+#ifdef BIGINT_STATS
+
+void stats_op(int op, size_t n);
+void stats_clamp(size_t erased);
+
+class stats_tier_scope
+{
+public:
+	stats_tier_scope(int tier);
+	~stats_tier_scope();
+
+private:
+	int tier;
+	bool outermost;
+	uint64_t start;
+};
+
+	#define STATS_OP(op, n) stats_op(bigint_stats::op, (n))
+	#define STATS_CLAMP(erased) stats_clamp(erased)
+	#define STATS_TIER(tier) stats_tier_scope stats_tier_scope_(bigint_stats::tier)
+
+#else
+
+	#define STATS_OP(op, n)
+	#define STATS_CLAMP(erased)
+	#define STATS_TIER(tier)
+
+#endif
@@ -1,8 +1,25 @@
 #include "bigint.hpp"
+#include "bigint_accumulator.hpp"
+#include "bigint_array.hpp"
+#include "bigint_batch.hpp"
+#include "bigint_expr.hpp"
+#include "bigint_factor.hpp"
+#include "bigint_mod.hpp"
+#include "bigint_parallel.hpp"
+#include "bigint_rns.hpp"
+#include "bigint_series.hpp"
+#include "bigint_sort.hpp"
+#include "bigint_tree.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
 #include <random>
+#include <sstream>
+#include <unordered_set>
 
 class bigint_test
 {
@@ -205,6 +222,162 @@ public:
 		}
 	}
 
+	void multiword()
+	{
+		std::mt19937 g(time(0));
+
+		for (int i = 0; i < 300; ++i)
+		{
+			bigint a = g(), b = g();
+
+			for (int j = g() % 40; j >= 0; --j)
+				a = (a << 32) + g();
+
+			for (int j = g() % 20; j >= 0; --j)
+				b = (b << 32) + g();
+
+			if (g() % 2)
+				a = -a;
+
+			if (b == 0)
+				b = 1;
+
+			auto qr = a.div(b);
+
+			assert(qr.first * b + qr.second == a);
+			assert(qr.second.abs() < b.abs());
+			assert((a * b) / b == a);
+			assert((a + b) - b == a);
+			assert(((a << 77) >> 77) == a);
+			assert(bigint(a.to_string()) == a);
+			assert(bigint(a.to_string(16, "0x")) == a);
+		}
+	}
+
+	void algorithms()
+	{
+		// Forces Karatsuba, Burnikel-Ziegler and divide-and-conquer
+		// radix conversion on small operands
+		bigint_thresholds saved = bigint::get_thresholds();
+		bigint_thresholds small = {4, 4, 4, 2, 2};
+
+		bigint::set_thresholds(small);
+		multiword();
+		bigint::set_thresholds(saved);
+	}
+
+	void expressions()
+	{
+		using bigint_expr::lazy;
+
+		std::mt19937 g(time(0));
+
+		for (int i = 0; i < 300; ++i)
+		{
+			bigint v[5];
+
+			for (auto &x : v)
+			{
+				x = g();
+
+				for (int j = g() % 8; j >= 0; --j)
+					x = (x << 32) + g();
+
+				if (g() % 2)
+					x = -x;
+			}
+
+			bigint &a = v[0], &b = v[1], &c = v[2], &d = v[3], &e = v[4];
+			bigint small = (g() % 2) ? -bigint(g()) : bigint(g());
+
+			bigint r = lazy(a) * b + lazy(c) * d - e;
+			assert(r == a * b + c * d - e);
+
+			assert(bigint(lazy(a) - lazy(b) * small) == a - b * small);
+			assert(bigint(lazy(a) * (lazy(b) + c)) == a * (b + c));
+
+			bigint x = a;
+			x.addmul(b, c);
+			assert(x == a + b * c);
+			x.submul(b, small);
+			assert(x == a + b * c - b * small);
+
+			x = a;
+			x += lazy(b) * small;
+			assert(x == a + b * small);
+			x -= lazy(x) * c;  // aliased
+			assert(x == (a + b * small) * (bigint(1) - c));
+
+			x = a;
+			assign(x, lazy(x) + lazy(b) * c);  // in place
+			assert(x == a + b * c);
+			assign(x, lazy(b) * c - x);  // aliased
+			assert(x == -a);
+			x.addmul(x, x);
+			assert(x == -a + a * a);
+
+			x = a;
+			x += x;
+			assert(x == a * 2);
+			x -= x;
+			assert(x == 0);
+			x -= a;
+			assert(x == -a);
+
+			bigint y = std::move(x);
+			assert(y == -a);
+			assert(x == 0 && x.to_string() == "0" && bigint_view(x).word_count() == 0);
+			assert(x.bit_length() == 0 && -x == 0 && x.to_long() == 0 && x * b == 0 && b.divisible_by(b + x));
+
+			std::vector<char> buf(x.serialized_size());
+			x.serialize(buf.data(), buf.size());
+			assert(bigint::deserialize(buf.data(), buf.size()) == 0);
+
+			x += b;
+			assert(x == b);
+			x = b;
+			swap(x, y);
+			assert(x == -a && y == b);
+		}
+	}
+
+	void stats()
+	{
+		bigint a = "123456789012345678901234567890";
+		bigint b = "987654321098765432109876543210";
+
+		bigint_stats::reset();
+		bigint c = a * b + a;
+		std::string str = c.to_string();
+
+		bigint_stats s = bigint_stats::snapshot();
+
+		if (!bigint_stats::enabled())
+		{
+			assert(s.calls[bigint_stats::OP_MUL] == 0);
+			assert(s.allocations == 0);
+			return;
+		}
+
+		assert(s.calls[bigint_stats::OP_MUL] == 1);
+		assert(s.sizes[bigint_stats::OP_MUL][2] == 1);  // 4 words
+		assert(s.calls[bigint_stats::OP_ADD] == 1);
+		assert(s.calls[bigint_stats::OP_TO_STRING] == 1);
+		assert(s.tier_calls[bigint_stats::TIER_MUL_BASECASE] == 1);
+		assert(s.tier_calls[bigint_stats::TIER_GET_STR_BASECASE] == 1);
+		assert(s.allocations > 0 && s.allocated_bytes >= s.allocations * 4);
+
+		bigint_stats::reset();
+		s = bigint_stats::snapshot();
+		assert(s.calls[bigint_stats::OP_MUL] == 0);
+		assert(s.allocations == 0);
+
+		// Binary minus is counted as a subtraction
+		c = c - a;
+		s = bigint_stats::snapshot();
+		assert(s.calls[bigint_stats::OP_SUB] == 1 && s.calls[bigint_stats::OP_ADD] == 0);
+	}
+
 	void logic()
 	{
 		assert(!bigint(0) == !0);
@@ -251,6 +424,1189 @@ public:
 
 			assert(i1 == i2);
 		}
+
+		bool thrown = false;
+
+		try
+		{
+			bigint::from_byte_array(std::string("\x01\x02\x03", 3));
+		}
+		catch (bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+		assert(bigint::from_byte_array(std::string(1, 0)) == 0);
+	}
+
+	void import_export()
+	{
+		std::mt19937 g(time(0));
+
+		const unsigned char be[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+		assert(bigint::import_bytes(be, 5) == bigint("0x0102030405"));
+		assert(bigint::import_bytes(be, 5, bigint_order::little, bigint_order::little) == bigint("0x0504030201"));
+		assert(bigint::import_bytes(be, 4, bigint_order::little, bigint_order::big, 2) == bigint("0x02010403"));
+
+		unsigned char out[8];
+		assert(bigint("0x0102030405").export_size() == 5);
+		assert(bigint(-0x0102).export_bytes(out, sizeof(out)) == 2);
+		assert(out[0] == 0x01 && out[1] == 0x02);
+		assert(bigint(0).export_size() == 0);
+		assert(bigint(0x10203).export_size(2) == 4);
+
+		bigint_order orders[] = {bigint_order::little, bigint_order::native, bigint_order::big};
+
+		for (int i = 0; i < 300; ++i)
+		{
+			bigint a = g();
+
+			for (int j = g() % 10; j >= 0; --j)
+				a = (a << 32) + g();
+
+			a >>= g() % 32;
+
+			size_t ws = 1 + g() % 9;
+			bigint_order e = orders[g() % 3], o = orders[g() % 3];
+			std::string buf(a.export_size(ws), 0);
+
+			assert(buf.size() % ws == 0 && buf.size() >= (a.bit_length() + 7) / 8);
+			assert(a.export_bytes(&buf[0], buf.size(), e, o, ws) == buf.size());
+			assert(bigint::import_bytes(buf.data(), buf.size(), e, o, ws) == a);
+
+			buf.resize(a.export_size());
+			a.export_bytes(&buf[0], buf.size());
+
+			std::string hex;
+
+			for (unsigned char c : buf)
+			{
+				hex.push_back("0123456789ABCDEF"[c >> 4]);
+				hex.push_back("0123456789ABCDEF"[c & 15]);
+			}
+
+			assert(bigint("0x" + hex) == a);
+		}
+	}
+
+	void array_file()
+	{
+		std::mt19937 g(time(0));
+		std::vector<bigint> values;
+		const char *path = "bigint_array_test.bin";
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			bigint a = g() % 3;
+
+			for (int j = g() % 10; j > 0; --j)
+				a = (a << 32) + g();
+
+			if (g() % 2)
+				a = -a;
+
+			values.push_back(a);
+		}
+
+		{
+			bigint_array_writer writer(path);
+
+			for (auto &v : values)
+				writer.write(v);
+
+			writer.close();
+		}
+
+		{
+			bigint_array_reader reader(path);
+			assert(reader.size() == values.size());
+
+			for (size_t i = 0; i < values.size(); ++i)
+				assert(bigint(reader[i]) == values[i] && bigint(reader.at(i)) == values[i]);
+		}
+
+		FILE *f = fopen(path, "r+b");
+		fputc('X', f);
+		fclose(f);
+
+		bool thrown = false;
+
+		try
+		{
+			bigint_array_reader reader(path);
+		}
+		catch (bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+		std::remove(path);
+	}
+
+	void views()
+	{
+		std::mt19937 g(time(0));
+
+		for (int i = 0; i < 300; ++i)
+		{
+			bigint a = g(), b = g();
+
+			for (int j = g() % 10; j >= 0; --j)
+				a = (a << 32) + g();
+
+			for (int j = g() % 10; j >= 0; --j)
+				b = (b << 32) + g();
+
+			if (g() % 2)
+				a = -a;
+
+			if (g() % 2)
+				b = -b;
+
+			bigint_view va = a, vb = b;
+
+			assert(va + vb == a + b && a - vb == a - b && va * b == a * b);
+			assert(va / vb == a / b && va % vb == a % b);
+			assert((va & vb) == (a & b) && (va | vb) == (a | b) && (va ^ vb) == (a ^ b) && ~va == ~a);
+			assert((va < vb) == (a < b) && (va == vb) == (a == b) && (b >= va) == (b >= a));
+			assert(va.to_string(16, "0x") == a.to_string(16, "0x"));
+
+			// Two's complement identities
+			assert((a & b) + (a | b) == a + b);
+			assert((a ^ b) == (a | b) - (a & b));
+			assert((a & ~a) == 0 && (a | ~a) == -1);
+		}
+
+		const uint32_t words[] = {0, 1, 0, 0};
+		bigint_view v(words, 4, 1);
+
+		assert(v.word_count() == 2 && v == bigint("-0x100000000"));
+		assert(bigint_view(words, 1, 1) == bigint(0) && !bigint_view(words, 1, 1).is_negative());
+		assert(bigint(-5) < bigint(-3) && bigint(-3) > bigint(-5) && v < -v);
+		assert((bigint(-1) & bigint("0x1234567890")) == bigint("0x1234567890"));
+		assert((bigint(6) | bigint("-0x100000000")) == bigint("-0xFFFFFFFA"));
+	}
+
+	void batch()
+	{
+		std::mt19937 g(time(0));
+		const size_t lanes = 37, limbs = 8;
+
+		// Words of all ones stress the carries
+		auto random_word = [&]() -> uint32_t { return (g() % 4 == 0) ? UINT32_MAX : g(); };
+
+		bigint_batch a(lanes, limbs), b(lanes, limbs);
+		std::vector<bigint> av, bv;
+
+		for (size_t i = 0; i < lanes; ++i)
+		{
+			bigint x = 0, y = 0;
+
+			for (size_t j = g() % (limbs + 1); j > 0; --j)
+				x = (x << 32) + random_word();
+
+			for (size_t j = g() % (limbs + 1); j > 0; --j)
+				y = (y << 32) + random_word();
+
+			if (i % 5 == 0)
+				y = x;
+
+			a.set(i, x);
+			b.set(i, y);
+			av.push_back(x);
+			bv.push_back(y);
+		}
+
+		bigint wrap = bigint(1) << (32 * limbs);
+		bigint_batch r;
+
+		bigint_batch::add(r, a, b);
+		for (size_t i = 0; i < lanes; ++i)
+			assert(r.get(i) == (av[i] + bv[i]) % wrap);
+
+		bigint_batch::sub(r, a, b);
+		for (size_t i = 0; i < lanes; ++i)
+			assert(r.get(i) == (av[i] - bv[i] + wrap) % wrap);
+
+		bigint_batch::mul(r, a, b);
+		assert(r.limbs() == 2 * limbs);
+		for (size_t i = 0; i < lanes; ++i)
+			assert(r.get(i) == av[i] * bv[i]);
+
+		std::vector<signed char> c = bigint_batch::cmp(a, b);
+		for (size_t i = 0; i < lanes; ++i)
+			assert(c[i] == (av[i] < bv[i] ? -1 : av[i] > bv[i] ? 1 : 0));
+
+		bigint_batch p;
+		bigint_batch::mul(p, a, b);
+
+		bigint moduli[] = {7, UINT32_MAX, bigint(1) << 96, (bigint(1) << 128) - 159, av[1] + 1, (av[2] << 200) + 1};
+
+		for (auto &m : moduli)
+		{
+			bigint_batch::mod(r, a, m);
+			for (size_t i = 0; i < lanes; ++i)
+				assert(r.get(i) == av[i] % m);
+
+			bigint_batch::mod(r, p, m);
+			for (size_t i = 0; i < lanes; ++i)
+				assert(r.get(i) == (av[i] * bv[i]) % m);
+		}
+
+		bool thrown = false;
+
+		try
+		{
+			a.set(0, -bigint(1));
+		}
+		catch (bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+	}
+
+	void parallel()
+	{
+		std::mt19937 g(time(0));
+		bigint_executor ex(4);
+		std::vector<bigint> values;
+
+		// Skewed sizes, so that the chunks differ in length
+		for (int i = 0; i < 500; ++i)
+		{
+			bigint a = g();
+
+			for (int j = (i % 50 == 0) ? 200 : g() % 4; j > 0; --j)
+				a = (a << 32) + g();
+
+			values.push_back((i % 3 == 0) ? -a : a);
+		}
+
+		std::vector<std::string> strings(values.size());
+		parallel_transform(
+			values.begin(), values.end(), strings.begin(), [](const bigint &v) { return v.to_string(16); },
+			[](const bigint &v) { return bigint_cost(v); }, ex);
+
+		for (size_t i = 0; i < values.size(); ++i)
+			assert(strings[i] == values[i].to_string(16));
+
+		strings = parallel_to_string(values);
+		std::vector<bigint> parsed = parallel_parse(strings);
+
+		for (size_t i = 0; i < values.size(); ++i)
+			assert(strings[i] == values[i].to_string() && parsed[i] == values[i]);
+
+		bigint m = (bigint(1) << 127) - 1;
+		bigint e = m - 2;
+		std::vector<bigint> inv = parallel_powmod(values, e, m);
+
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			bigint r = values[i] % m;
+
+			if (r < 0)
+				r += m;
+
+			assert(inv[i] == values[i].powmod(e, m));
+			assert(r == 0 || inv[i] * r % m == 1);
+		}
+
+		assert(bigint(3).powmod(0, 7) == 1 && bigint(3).powmod(5, 1) == 0 && bigint(-2).powmod(3, 7) == 6);
+
+		// Nested runs, counted once per item
+		std::vector<int> hits(100);
+		ex.run(
+			hits.size(), [&](size_t i) { ex.run(1, [&](size_t) { hits[i]++; }, [](size_t) { return 1; }); },
+			[](size_t) { return 1; });
+
+		for (int h : hits)
+			assert(h == 1);
+
+		bool thrown = false;
+
+		try
+		{
+			ex.run(
+				100,
+				[](size_t i) {
+					if (i == 42)
+						throw bigint_exception("item");
+				},
+				[](size_t) { return 1; });
+		}
+		catch (bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+	}
+
+	void hashing()
+	{
+		std::mt19937 g(time(0));
+		std::unordered_set<bigint> set;
+		std::vector<bigint> values;
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			bigint a = g() % 100;
+
+			for (int j = g() % 4; j > 0; --j)
+				a = (a << 32) + g();
+
+			values.push_back((g() % 2) ? -a : a);
+			set.insert(values.back());
+		}
+
+		for (auto &v : values)
+		{
+			bigint copy(v.to_string());
+
+			assert(copy == v && !(copy != v));
+			assert(std::hash<bigint>()(copy) == std::hash<bigint>()(v));
+			assert(std::hash<bigint_view>()(v) == v.hash());
+			assert(set.count(copy) == 1);
+		}
+
+		bigint a = 12345, b = -12345;
+		assert(a != b && (a + b) == 0 && (a + b).hash() == bigint(0).hash());
+		assert(bigint(1) << 64 != (bigint(1) << 64) + 1);
+		assert(bigint(1).hash() != bigint(-1).hash());
+	}
+
+	void comparison()
+	{
+		std::mt19937 g(time(0));
+
+		// Equal sizes differing in one word, on both sides of the SIMD blocks
+		for (int n = 1; n <= 40; ++n)
+		{
+			bigint a = 1;
+
+			for (int j = 1; j < n; ++j)
+				a = (a << 32) + g();
+
+			for (int k = 0; k < n; ++k)
+			{
+				bigint b = a + (bigint(1) << (32 * k));
+				bigint c = a - (bigint(1) << (32 * k));
+
+				assert(a < b && b > a && a <= b && !(a >= b) && a != b);
+				assert(c < a && a > c && bigint_view::compare(c, a) == -1);
+				assert(-a > -b && -c > -a);
+			}
+
+			assert(a == bigint(a.to_string()) && a >= a && a <= a);
+		}
+	}
+
+	void sorting()
+	{
+		std::mt19937 g(time(0));
+		std::vector<bigint> values;
+
+		// Many values share their top words, so the radix passes go deep
+		for (int i = 0; i < 50000; ++i)
+		{
+			bigint a = g() % 3;
+
+			for (int j = g() % 4; j > 0; --j)
+				a = (a << 32) + ((g() % 4) ? g() % 2 : g());
+
+			values.push_back((g() % 3 == 0) ? -a : a);
+		}
+
+		std::vector<bigint> expected = values;
+		std::sort(expected.begin(), expected.end());
+
+		std::vector<bigint> sorted = values;
+		bigint_sort(sorted);
+		assert(sorted == expected);
+
+		bigint_executor ex(4);
+		sorted = values;
+		bigint_sort(sorted, &ex);
+		assert(sorted == expected);
+
+		// Records by key, equal keys keep their order
+		struct record
+		{
+			bigint key;
+			int id;
+		};
+
+		std::vector<record> records;
+
+		for (size_t i = 0; i < values.size(); ++i)
+			records.push_back(record{values[i], static_cast<int>(i)});
+
+		bigint_sort_by(records.begin(), records.end(), [](const record &r) -> const bigint & { return r.key; });
+
+		for (size_t i = 0; i < records.size(); ++i)
+		{
+			assert(records[i].key == expected[i]);
+			assert(i == 0 || records[i - 1].key != records[i].key || records[i - 1].id < records[i].id);
+		}
+	}
+
+	void trees()
+	{
+		std::mt19937 g(time(0));
+		bigint_executor ex(4);
+
+		assert(bigint(12).gcd(-18) == 6 && bigint(0).gcd(5) == 5 && bigint(0).gcd(0) == 0);
+
+		std::vector<bigint> moduli;
+
+		for (int i = 0; i < 300; ++i)
+		{
+			bigint m = g() | 1;
+
+			for (int j = g() % 3; j > 0; --j)
+				m = (m << 32) + g();
+
+			moduli.push_back(m);
+		}
+
+		bigint x = 1;
+
+		for (int i = 0; i < 200; ++i)
+			x = (x << 32) + g();
+
+		std::vector<bigint> rems = batch_mod(x, moduli);
+		std::vector<bigint> neg = batch_mod(-x, moduli, &ex);
+
+		for (size_t i = 0; i < moduli.size(); ++i)
+			assert(rems[i] == x % moduli[i] && neg[i] == -x % moduli[i]);
+
+		// Products of two primes, some sharing one
+		std::vector<bigint> primes;
+
+		for (bigint p = (bigint(1) << 64) + 1; primes.size() < 12; p += 2)
+		{
+			if (bigint(2).powmod(p - 1, p) == 1)
+				primes.push_back(p);
+		}
+
+		std::vector<bigint> keys = {primes[0] * primes[1], primes[2] * primes[3], primes[1] * primes[4],
+		                            primes[5] * primes[6], primes[7] * primes[8], primes[9] * primes[7],
+		                            primes[10] * primes[11]};
+
+		for (bigint_executor *e : {static_cast<bigint_executor *>(nullptr), &ex})
+		{
+			std::vector<bigint> gcds = batch_gcd(keys, e);
+
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				bigint expected = 1;
+
+				for (size_t j = 0; j < keys.size(); ++j)
+				{
+					if (j != i)
+						expected = expected * keys[j] / expected.gcd(keys[j]);
+				}
+
+				assert(gcds[i] == keys[i].gcd(expected));
+			}
+
+			assert(gcds[0] == primes[1] && gcds[1] == 1 && gcds[4] == primes[7]);
+		}
+	}
+
+	void rns()
+	{
+		std::mt19937 g(time(0));
+		const int n = 6;
+
+		// Signed 64-bit entries of a 6x6 matrix, dot products of rows need 2 * 64 + 3 bits
+		bigint_rns ctx(n * 64 + 16);
+		std::vector<bigint> a(n * n);
+
+		for (auto &x : a)
+		{
+			x = (bigint(g()) << 32) + g();
+
+			if (g() % 2)
+				x = -x;
+		}
+
+		bigint x = a[0], y = a[1];
+		bigint_rns::residues rx = ctx.to_rns(x), ry = ctx.to_rns(y);
+
+		assert(ctx.from_rns(rx) == x && ctx.from_rns(ry) == y);
+		assert(ctx.from_rns(ctx.add(rx, ry)) == x + y);
+		assert(ctx.from_rns(ctx.sub(rx, ry)) == x - y);
+		assert(ctx.from_rns(ctx.mul(rx, ry)) == x * y);
+		assert(ctx.from_rns(ctx.to_rns(0)) == 0);
+
+		// Dot products of rows, accumulated in residues
+		for (int i = 0; i < n; ++i)
+		{
+			bigint expected = 0;
+			bigint_rns::residues acc = ctx.to_rns(0);
+
+			for (int j = 0; j < n; ++j)
+			{
+				expected += a[i * n + j] * a[((i + 1) % n) * n + j];
+				acc = ctx.add(acc, ctx.mul(ctx.to_rns(a[i * n + j]), ctx.to_rns(a[((i + 1) % n) * n + j])));
+			}
+
+			assert(ctx.from_rns(acc) == expected);
+		}
+
+		bigint big = (bigint(1) << (n * 64 + 16)) - 1;
+		assert(ctx.from_rns(ctx.to_rns(big)) == big && ctx.from_rns(ctx.to_rns(-big)) == -big);
+
+		// Enough primes for the product tree and for several chunks per operation
+		bigint_executor ex(4);
+
+		for (size_t bits : {3000, 150000})
+		{
+			bigint_rns large(2 * bits + 1);
+			bigint u = bigint::random_bits(bits, g), w = -bigint::random_bits(bits, g);
+			bigint_rns::residues ru = large.to_rns(u, &ex), rw = large.to_rns(w);
+
+			assert(large.from_rns(ru) == u && large.from_rns(rw, &ex) == w);
+			assert(large.from_rns(large.add(ru, rw, &ex), &ex) == u + w && large.from_rns(large.add(ru, rw)) == u + w);
+			assert(large.from_rns(large.sub(ru, rw, &ex)) == u - w && large.sub(ru, rw, &ex) == large.sub(ru, rw));
+			assert(large.from_rns(large.mul(ru, rw, &ex), &ex) == u * w && large.mul(ru, rw, &ex) == large.mul(ru, rw));
+		}
+	}
+
+	void accumulator()
+	{
+		std::mt19937 g(time(0));
+		bigint_accumulator acc;
+		bigint expected = 0;
+
+		assert(acc.value() == 0);
+
+		for (int i = 0; i < 5000; ++i)
+		{
+			bigint a = g();
+
+			for (int j = g() % 6; j > 0; --j)
+				a = (a << 32) + g();
+
+			if (g() % 2)
+				a = -a;
+
+			if (g() % 3)
+			{
+				acc += a;
+				expected += a;
+			}
+			else
+			{
+				acc -= a;
+				expected -= a;
+			}
+
+			if (i % 500 == 0)
+				assert(acc.value() == expected);
+		}
+
+		assert(acc.value() == expected);
+
+		// Negative totals with carries out of the top column
+		acc.clear();
+		acc -= bigint(1);
+		acc += bigint(UINT32_MAX);
+		acc -= (bigint(1) << 64);
+		assert(acc.value() == bigint(UINT32_MAX) - 1 - (bigint(1) << 64));
+	}
+
+	void exact_division()
+	{
+		std::mt19937 g(time(0));
+
+		auto random = [&](int words) {
+			bigint a = g() | 1;
+
+			for (int j = words - 1; j > 0; --j)
+				a = (a << 32) + g();
+
+			return a;
+		};
+
+		for (int i = 0; i < 400; ++i)
+		{
+			int dn = 1 + g() % ((i % 20 == 0) ? 120 : 8);
+			bigint d = random(dn) << (g() % 80);
+			bigint q = random(1 + g() % ((i % 20 == 0) ? 120 : 8));
+
+			if (g() % 2)
+				d = -d;
+
+			if (g() % 2)
+				q = -q;
+
+			bigint a = q * d;
+
+			assert(a.divexact(d) == q);
+			assert(a.divisible_by(d) && a.divisible_by(q) && a.divisible_by(-d));
+			assert(!(a + 1).divisible_by(d) || d.abs() == 1);
+			assert(!(a + d / 2).divisible_by(d) || d.abs() < 2);
+			assert((a * 3).divisible_by(d * 3) && !(a * 3 + d).divisible_by(d * 3));
+			assert(d.divisible_by(d * 2) == false);
+		}
+
+		assert(bigint(0).divexact(7) == 0 && bigint(0).divisible_by(0) && !bigint(5).divisible_by(0));
+		assert(bigint(-36).divexact(4) == -9 && bigint(36).divisible_by(-12) && !bigint(36).divisible_by(5));
+
+		bigint p = bigint(3) << 100;
+		assert(p.divisible_by_2exp(0) && p.divisible_by_2exp(100) && !p.divisible_by_2exp(101));
+		assert((-p).divisible_by_2exp(64) && bigint(0).divisible_by_2exp(1000) && !bigint(1).divisible_by_2exp(1));
+		assert(!bigint(6).divisible_by_2exp(64));
+	}
+
+	void powers_of_two()
+	{
+		std::mt19937 g(time(0));
+
+		for (int i = 0; i < 2000; ++i)
+		{
+			bigint x = g();
+
+			for (int j = g() % 5; j > 0; --j)
+				x = (x << 32) + ((g() % 4) ? g() : 0);
+
+			if (g() % 2)
+				x = -x;
+
+			size_t k = g() % 200;
+			bigint p = bigint(1) << k;
+
+			bigint r = x.mod_2exp(k);
+			bigint q = x.fdiv_q_2exp(k);
+
+			assert(r >= 0 && r < p && q * p + r == x);
+			assert(x.tdiv_q_2exp(k) == x / p && x.tdiv_q_2exp(k) == (x >> k));
+			assert(x.mul_2exp(k) == x * p && x.mul_2exp(k) == (x << k));
+		}
+
+		assert(bigint(-1).fdiv_q_2exp(1000) == -1 && bigint(-1).tdiv_q_2exp(1000) == 0);
+		assert(bigint(-7).fdiv_q_2exp(1) == -4 && bigint(-8).fdiv_q_2exp(2) == -2);
+		assert(bigint(-1).mod_2exp(64) == (bigint(1) << 64) - 1 && bigint(-(1LL << 40)).mod_2exp(40) == 0);
+		assert(bigint(12345).mod_2exp(0) == 0 && bigint(0).mul_2exp(100) == 0);
+
+		// Negative counts shift the other way, INT_MIN included
+		assert((bigint(12345) << INT_MIN) == 0 && (bigint(-12345) << INT_MIN) == 0);
+		assert((bigint(3) >> -2) == 12 && (bigint(12) << -2) == 3);
+	}
+
+	void series()
+	{
+		bigint_executor ex(4);
+
+		// e = 1 + sum 1/n!
+		auto one = [](size_t) { return bigint(1); };
+		auto n = [](size_t i) { return bigint(static_cast<unsigned long>(i)); };
+
+		bigint_pqt e = bigint_binary_split(one, n, one, 1, 300);
+		bigint_pqt e_par = bigint_binary_split(one, n, one, 1, 300, &ex);
+
+		assert(e.P == e_par.P && e.Q == e_par.Q && e.T == e_par.T);
+		assert(bigint_fixed_point(e.Q + e.T, e.Q, 50) == "2.71828182845904523536028747135266249775724709369995");
+
+		// Chudnovsky: pi = 426880 * sqrt(10005) * Q / T
+		auto p = [](size_t i) {
+			bigint k = static_cast<unsigned long>(i);
+			return (i == 0) ? bigint(1) : -(k * 6 - 5) * (k * 2 - 1) * (k * 6 - 1);
+		};
+		auto q = [](size_t i) {
+			bigint k = static_cast<unsigned long>(i);
+			return (i == 0) ? bigint(1) : k * k * k * bigint("10939058860032000");
+		};
+		auto a = [](size_t i) { return bigint(static_cast<unsigned long>(i)) * 545140134 + 13591409; };
+
+		const size_t digits = 100;
+		bigint scale = bigint("1" + std::string(digits, '0'));
+		bigint_pqt pi = bigint_binary_split(p, q, a, 0, digits / 14 + 2, &ex);
+		bigint sqrt10005 = (scale * scale * 10005).sqrt();
+
+		std::string s = bigint_fixed_point(sqrt10005 * pi.Q * 426880, pi.T * scale, digits);
+		assert(s.compare(0, 52, "3.14159265358979323846264338327950288419716939937510") == 0);
+
+		assert(bigint_fixed_point(-1, 3, 3) == "-0.333" && bigint_fixed_point(7, 2, 0) == "3");
+		assert(bigint_fixed_point(1, 200, 2) == "0.00");
+	}
+
+	void factorization()
+	{
+		bigint m61 = (bigint(1) << 61) - 1, m89 = (bigint(1) << 89) - 1;
+
+		assert(is_probable_prime(2) && is_probable_prime(8191) && is_probable_prime(m61) && is_probable_prime(m89));
+		assert(!is_probable_prime(1) && !is_probable_prime(-7) && !is_probable_prime(561));
+		assert(!is_probable_prime(m61 * m89));
+
+		// Strong pseudoprime to the bases 2, 3, ..., 23
+		bigint spsp = "3825123056546413051";
+		assert(is_probable_prime(spsp, 9) && !is_probable_prime(spsp));
+
+		std::vector<bigint> f = factorize(-360);
+		assert(f == std::vector<bigint>({2, 2, 2, 3, 3, 5}));
+		assert(factorize(1).empty() && factorize(m89) == std::vector<bigint>({m89}));
+
+		bool thrown = false;
+
+		try
+		{
+			factorize(0);
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+
+		// Random primes of bits bits
+		std::mt19937_64 rng(47);
+		auto prime = [&](size_t bits) {
+			bigint p;
+
+			do
+			{
+				p = bigint(static_cast<unsigned long long>(rng())) << 64 | bigint(static_cast<unsigned long long>(rng()));
+				p = p.mod_2exp(bits) | (bigint(1) << (bits - 1)) | 1;
+			} while (!is_probable_prime(p));
+
+			return p;
+		};
+
+		bigint_executor ex(4);
+		const size_t sizes[][3] = {{20, 40, 0}, {30, 30, 0}, {44, 44, 0}, {50, 50, 20}, {32, 32, 32}, {36, 72, 0}};
+
+		for (auto &sz : sizes)
+		{
+			std::vector<bigint> primes;
+
+			for (size_t bits : sz)
+			{
+				if (bits != 0)
+					primes.push_back(prime(bits));
+			}
+
+			primes.push_back(primes[0]);  // A square factor
+			primes.push_back(7);
+			std::sort(primes.begin(), primes.end());
+
+			bigint n = 1;
+
+			for (auto &p : primes)
+				n *= p;
+
+			assert(factorize(n) == primes);
+			assert(factorize(n, &ex) == primes);
+		}
+	}
+
+	void modular()
+	{
+		std::mt19937 rng(48);
+		auto random = [&](size_t bits) {
+			bigint r = 0;
+
+			for (size_t i = 0; i < bits; i += 32)
+				r = (r << 32) + bigint(static_cast<unsigned int>(rng()));
+
+			return r.mod_2exp(bits);
+		};
+
+		// Unrolled sizes and the generic path around them
+		for (size_t bits : {20, 100, 255, 256, 384, 512, 600, 2048, 4096})
+		{
+			bigint m = random(bits) | (bigint(1) << (bits - 1)) | 1;
+			bigint_mod_ctx ctx(m);
+
+			assert(ctx.modulus() == m && ctx.limbs() == (bits + 31) / 32);
+			assert(ctx.one().value() == 1 && ctx.zero().is_zero() && ctx(-1).value() == m - 1);
+
+			bigint x = random(bits) % m, ref = x;
+			modint a = ctx(x);
+
+			for (int i = 0; i < 50; ++i)
+			{
+				bigint y = random(bits + 7);
+				modint b = ctx(y);
+
+				switch (i % 3)
+				{
+				case 0:
+					a *= b;
+					ref = ref * y % m;
+					break;
+				case 1:
+					a += b;
+					ref = (ref + y) % m;
+					break;
+				case 2:
+					a = a - b;
+					ref = ((ref - y) % m + m) % m;
+					break;
+				}
+
+				assert(a.value() == ref);
+			}
+
+			assert((-a).value() == (m - ref) % m && (a + -a).is_zero());
+			assert(a.pow(12345).value() == ref.powmod(12345, m) && a.pow(0) == ctx.one());
+
+			if (ref.gcd(m) == 1)
+				assert(a * a.inverse() == ctx.one() && a.pow(-3) * a.pow(3) == ctx.one());
+
+			assert(ctx(m - 1) * ctx(m - 1) == ctx.one());
+		}
+
+		bigint_mod_ctx ctx(15), other(15);
+		assert(ctx(4) != other(4) && ctx(19) == ctx(4));
+
+		bool thrown = false;
+
+		try
+		{
+			ctx(4) + other(4);
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+		thrown = false;
+
+		try
+		{
+			ctx(6).inverse();
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+		thrown = false;
+
+		try
+		{
+			bigint_mod_ctx even(16);
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+		assert(bigint(3).invmod(7) == 5 && bigint(-3).invmod(7) == 2);
+	}
+
+	void multi_exponentiation()
+	{
+		std::mt19937 rng(49);
+		bigint p = (bigint(1) << 255) - 19;
+		bigint_mod_ctx ctx(p);
+
+		auto random = [&](size_t bits) {
+			bigint r = 0;
+
+			for (size_t i = 0; i < bits; i += 32)
+				r = (r << 32) + bigint(static_cast<unsigned int>(rng()));
+
+			return r.mod_2exp(bits);
+		};
+
+		// Straus below 32 bases, Pippenger from there
+		for (size_t n : {0, 1, 2, 5, 31, 32, 100})
+		{
+			for (size_t bits : {1, 20, 256, 700})
+			{
+				std::vector<modint> bases;
+				std::vector<bigint> exps;
+				modint ref = ctx.one();
+
+				for (size_t i = 0; i < n; ++i)
+				{
+					bases.push_back(ctx(random(256)));
+					exps.push_back((i % 7 == 3) ? bigint(0) : random(bits));
+					ref *= bases[i].pow(exps[i]);
+				}
+
+				assert(ctx.multi_pow(bases, exps) == ref);
+			}
+		}
+
+		std::vector<modint> values;
+
+		for (int i = 0; i < 1000; ++i)
+			values.push_back(ctx(random(300)));
+
+		std::vector<modint> inv = ctx.batch_inverse(values);
+
+		for (size_t i = 0; i < values.size(); ++i)
+			assert(values[i] * inv[i] == ctx.one());
+
+		assert(ctx.batch_inverse({}).empty());
+		assert(ctx.batch_inverse({ctx(2)})[0] == ctx((p + 1) / 2));
+
+		bool thrown = false;
+
+		try
+		{
+			values[500] = ctx.zero();
+			ctx.batch_inverse(values);
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+		thrown = false;
+
+		try
+		{
+			ctx.multi_pow({ctx(2)}, {-1});
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+	}
+
+	void random_values()
+	{
+		std::mt19937 rng32(50);
+		std::mt19937_64 rng64(50);
+		std::minstd_rand rng31(50);
+
+		assert(bigint::random_bits(0, rng32) == 0);
+
+		for (size_t bits : {1, 31, 32, 33, 64, 100, 1000})
+		{
+			bigint limit = bigint(1) << bits;
+			bool top32 = false, top64 = false, top31 = false;
+
+			for (int i = 0; i < 200; ++i)
+			{
+				bigint a = bigint::random_bits(bits, rng32), b = bigint::random_bits(bits, rng64);
+				bigint c = bigint::random_bits(bits, rng31);
+
+				assert(a >= 0 && a < limit && b >= 0 && b < limit && c >= 0 && c < limit);
+
+				top32 |= a.bit_length() == bits;
+				top64 |= b.bit_length() == bits;
+				top31 |= c.bit_length() == bits;
+			}
+
+			assert(top32 && top64 && top31);
+		}
+
+		// Every residue of a small bound shows up, close to uniformly
+		bigint bound = 5;
+		std::vector<bigint> small = bigint::random_below(bound, 5000, rng64);
+		size_t counts[5] = {0};
+
+		for (auto &v : small)
+		{
+			assert(v >= 0 && v < bound);
+			counts[v.to_int()]++;
+		}
+
+		for (size_t c : counts)
+			assert(c > 850 && c < 1150);
+
+		// Bounds just above a power of two reject the most
+		for (bigint b : {bigint(1), (bigint(1) << 64) + 1, (bigint(1) << 95) + 3, bigint("0xFFFFFFFF00000000FFFFFFFF")})
+		{
+			for (auto &v : bigint::random_below(b, 300, rng32))
+				assert(v >= 0 && v < b);
+
+			for (int i = 0; i < 300; ++i)
+			{
+				bigint v = bigint::random_below(b, rng64);
+				assert(v >= 0 && v < b);
+			}
+		}
+
+		assert(bigint::random_bits(64, 10, rng32).size() == 10);
+
+		bool thrown = false;
+
+		try
+		{
+			bigint::random_below(0, rng32);
+		}
+		catch (const bigint_exception &)
+		{
+			thrown = true;
+		}
+
+		assert(thrown);
+	}
+
+	void streams()
+	{
+		bigint a = "-0x1234567890ABCDEF";
+
+		std::ostringstream os;
+		os << a << ' ' << std::hex << a << ' ' << std::showbase << std::uppercase << a << ' ';
+		os << std::oct << -a << ' ' << std::dec << std::showpos << -a << ' ' << bigint(0);
+		assert(os.str() == a.to_string() + " -1234567890abcdef -0x1234567890ABCDEF 0o" + (-a).to_string(8) + " +" +
+		                       (-a).to_string() + " +0");
+
+		os.str("");
+		os.flags(std::ios_base::dec);
+		os << std::setw(8) << bigint(-42) << '|' << std::left << std::setw(5) << bigint(7) << '|';
+		os << std::internal << std::setfill('0') << std::setw(6) << bigint(-42);
+		assert(os.str() == "     -42|7    |-00042");
+
+		// Long enough to be written in several chunks
+		bigint big = bigint(7) << 400000;
+		os.str("");
+		os << std::noshowpos << big;
+		assert(os.str() == big.to_string());
+
+		std::istringstream is("  -123 0x1F 0o17 +42abc 99");
+		bigint x, y, z, w;
+		is >> x >> y >> z >> w;
+		assert(x == -123 && y == 31 && z == 15 && w == 42);
+
+		std::string rest;
+		is >> rest;
+		assert(rest == "abc");
+
+		is >> x;
+		assert(x == 99 && is.eof() && !is.fail());
+
+		std::istringstream hex_is("ff 0x10");
+		hex_is >> std::hex >> x >> y;
+		assert(x == 255 && y == 16);
+
+		std::istringstream bad("xyz");
+		bad >> x;
+		assert(bad.fail() && x == 255);
+
+		std::istringstream long_is(big.to_string());
+		long_is >> x;
+		assert(x == big);
+
+		// Digit counts around the chunk sizes, with leading zeros, in every base the parser knows
+		for (int base : {2, 8, 10, 16})
+		{
+			for (size_t len : {1, 6, 7, 8, 9, 10, 31, 32, 33, 500})
+			{
+				std::string digits(len, '0');
+
+				for (size_t i = 0; i < len; ++i)
+					digits[i] = "0123456789abcdef"[(i * 7 + len) % base];
+
+				std::string prefix = (base == 2) ? "0b" : (base == 8) ? "0o" : (base == 16) ? "0x" : "";
+				std::istringstream chunk_is(prefix + "000" + digits + " ");
+				chunk_is >> x;
+				assert(!chunk_is.fail() && x == bigint(prefix + digits));
+			}
+		}
+
+		std::istringstream zeros_is("-0000000000000000000");
+		zeros_is >> x;
+		assert(x == 0 && x.to_string() == "0");
+	}
+
+	void serialize()
+	{
+		std::mt19937 g(time(0));
+		std::string buf;
+
+		for (int i = 0; i < 300; ++i)
+		{
+			bigint a = g();
+
+			for (int j = g() % 20; j >= 0; --j)
+				a = (a << 32) + g();
+
+			if (g() % 2)
+				a = -a;
+
+			size_t off = buf.size();
+			buf.resize(off + a.serialized_size());
+			assert(a.serialize(&buf[off], buf.size() - off) == a.serialized_size());
+
+			size_t used;
+			assert(bigint::deserialize(&buf[off], buf.size() - off, &used) == a);
+			assert(used == a.serialized_size());
+		}
+
+		// Documented layout
+		std::string one = std::string("\x01\x01\x00\x00\x01\x00\x00\x00\x05\x00\x00\x00", 12);
+		char out[12];
+
+		assert(bigint(-5).serialize(out, sizeof(out)) == 12);
+		assert(std::string(out, 12) == one);
+		assert(bigint::deserialize(one.data(), one.size()) == -5);
+
+		// Zero-copy views on little-endian hosts, words aligned by the storage
+		uint32_t probe = 1;
+		bool little = *reinterpret_cast<unsigned char *>(&probe) == 1;
+
+		bigint big = (bigint(1) << 200) - 12345;
+		std::vector<uint32_t> storage(big.serialized_size() / 4 + 1);
+		char *aligned = reinterpret_cast<char *>(storage.data());
+		size_t vused = 0;
+
+		big.serialize(aligned, big.serialized_size());
+
+		for (const char *at : {aligned, aligned + 1})
+		{
+			bool thrown = false;
+
+			if (at != aligned)
+				memmove(aligned + 1, aligned, big.serialized_size());
+
+			try
+			{
+				bigint_view v = bigint::view_serialized(at, big.serialized_size(), &vused);
+
+				assert(v == big && vused == big.serialized_size());
+				assert(reinterpret_cast<const char *>(v.data()) == at + 8);
+			}
+			catch (const bigint_exception &)
+			{
+				thrown = true;
+			}
+
+			assert(thrown == (!little || at != aligned));
+		}
+
+		const char *bad[] = {
+			"\x02\x00\x00\x00\x01\x00\x00\x00\x05\x00\x00\x00",  // version
+			"\x01\x02\x00\x00\x01\x00\x00\x00\x05\x00\x00\x00",  // flags
+			"\x01\x00\x00\x00\x00\x00\x00\x00\x05\x00\x00\x00",  // no words
+			"\x01\x00\x00\x00\x02\x00\x00\x00\x05\x00\x00\x00",  // truncated
+		};
+
+		for (auto b : bad)
+		{
+			bool thrown = false;
+
+			try
+			{
+				bigint::deserialize(b, 12);
+			}
+			catch (bigint_exception &)
+			{
+				thrown = true;
+			}
+
+			assert(thrown);
+		}
 	}
 };
 
@@ -262,8 +1618,32 @@ int main()
 	test.sqrt();
 	test.abs();
 	test.arithmetic();
+	test.multiword();
+	test.algorithms();
+	test.expressions();
+	test.stats();
 	test.logic();
 	test.byte_array();
+	test.serialize();
+	test.import_export();
+	test.array_file();
+	test.views();
+	test.batch();
+	test.parallel();
+	test.hashing();
+	test.comparison();
+	test.sorting();
+	test.trees();
+	test.rns();
+	test.accumulator();
+	test.exact_division();
+	test.powers_of_two();
+	test.series();
+	test.factorization();
+	test.modular();
+	test.multi_exponentiation();
+	test.random_values();
+	test.streams();
 
 	return 0;
 }
@@ -0,0 +1,194 @@
+#include "bigint.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+
+/*
+ * Finds the crossover points of the algorithms behind operator*, div,
+ * to_string and conversion from string, in the spirit of GMP's tuneup.
+ *
+ * For every size n the plain algorithm (threshold disabled) is timed against
+ * one level of the fast algorithm (threshold = n, so the recursion falls back
+ * to the plain one below n). The threshold is the smallest size from which
+ * the fast algorithm wins at several consecutive sizes.
+ */
+
+struct tune_param
+{
+	const char *name;
+	const char *macro;
+	size_t bigint_thresholds::*field;
+	size_t max_size;
+	std::function<std::function<void()>(size_t)> setup;
+};
+
+static volatile size_t sink;
+static std::mt19937 rng(42);
+
+static bigint random_bigint(size_t nwords)
+{
+	std::string ba(nwords * 4 + 1, 0);
+
+	for (size_t i = 0; i < nwords * 4; ++i)
+		ba[i] = rng();
+
+	ba[nwords * 4 - 1] |= 0x80;
+
+	return bigint::from_byte_array(ba);
+}
+
+// Seconds per call, the best of several rounds
+static double time_fn(const std::function<void()> &fn)
+{
+	typedef std::chrono::steady_clock clock;
+
+	double best = std::numeric_limits<double>::max();
+
+	for (int round = 0; round < 5; ++round)
+	{
+		size_t iterations = 0;
+		double elapsed;
+		auto start = clock::now();
+
+		do
+		{
+			fn();
+			iterations++;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		} while (elapsed < 0.01);
+
+		best = std::min(best, elapsed / iterations);
+	}
+
+	return best;
+}
+
+static size_t tune(const tune_param &param, bool verbose)
+{
+	const size_t disabled = std::numeric_limits<size_t>::max() / 4;
+	const int wins_needed = 3;
+
+	bigint_thresholds saved = bigint::get_thresholds();
+	size_t found = 0;
+	int wins = 0;
+
+	for (size_t n = 4; n <= param.max_size; n += std::max<size_t>(1, n / 8))
+	{
+		auto fn = param.setup(n);
+		bigint_thresholds th = saved;
+
+		th.*param.field = disabled;
+		bigint::set_thresholds(th);
+		double plain = time_fn(fn);
+
+		th.*param.field = n;
+		bigint::set_thresholds(th);
+		double fast = time_fn(fn);
+
+		if (verbose)
+			fprintf(stderr, "%s: n=%zu plain=%.3gus fast=%.3gus\n", param.name, n, plain * 1e6, fast * 1e6);
+
+		if (fast < plain)
+		{
+			if (wins++ == 0)
+				found = n;
+
+			if (wins == wins_needed)
+				break;
+		}
+		else
+		{
+			wins = 0;
+		}
+	}
+
+	if (wins < wins_needed)
+		found = param.max_size;
+
+	saved.*param.field = found;
+	bigint::set_thresholds(saved);
+
+	return found;
+}
+
+int main(int argc, char **argv)
+{
+	std::string output;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strncmp(argv[i], "--output=", 9) == 0)
+			output = argv[i] + 9;
+		else if (strcmp(argv[i], "--verbose") == 0)
+			verbose = true;
+		else
+		{
+			fprintf(stderr, "Usage: %s [--output=bigint_thresholds.hpp] [--verbose]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Multiplication goes first, since everything else depends on it
+	tune_param params[] = {
+		{"mul", "MUL_KARATSUBA_THRESHOLD", &bigint_thresholds::mul_karatsuba, 256,
+		 [](size_t n) -> std::function<void()> {
+			 bigint a = random_bigint(n), b = random_bigint(n);
+			 return [=]() { sink += (a * b).size(); };
+		 }},
+		{"sqr", "SQR_KARATSUBA_THRESHOLD", &bigint_thresholds::sqr_karatsuba, 256,
+		 [](size_t n) -> std::function<void()> {
+			 bigint a = random_bigint(n);
+			 return [=]() { sink += (a * a).size(); };
+		 }},
+		{"div", "DIV_BZ_THRESHOLD", &bigint_thresholds::div_bz, 1024,
+		 [](size_t n) -> std::function<void()> {
+			 bigint a = random_bigint(2 * n), b = random_bigint(n);
+			 return [=]() { sink += a.div(b).first.size(); };
+		 }},
+		{"get_str", "GET_STR_DC_THRESHOLD", &bigint_thresholds::get_str_dc, 1024,
+		 [](size_t n) -> std::function<void()> {
+			 bigint a = random_bigint(n);
+			 return [=]() { sink += a.to_string().size(); };
+		 }},
+		{"set_str", "SET_STR_DC_THRESHOLD", &bigint_thresholds::set_str_dc, 4096,
+		 [](size_t n) -> std::function<void()> {
+			 std::string s = random_bigint(n).to_string();
+			 return [=]() { sink += bigint(s).size(); };
+		 }},
+	};
+
+	std::string header =
+		"/*\n"
+		" * Algorithm crossover points, in words.\n"
+		" * This file is generated by the tune executable (meson compile -C build tune).\n"
+		" */\n"
+		"\n"
+		"#pragma once\n"
+		"\n";
+
+	for (auto &param : params)
+	{
+		size_t value = tune(param, verbose);
+		fprintf(stderr, "%s = %zu\n", param.macro, value);
+		header += "#define " + std::string(param.macro) + " " + std::to_string(value) + "\n";
+	}
+
+	if (output.empty())
+	{
+		fputs(header.c_str(), stdout);
+	}
+	else
+	{
+		std::ofstream out(output);
+		out << header;
+	}
+
+	return 0;
+}